@@ -0,0 +1,125 @@
+// A frame of particles::Storage & its drawing on the CPU, without a window or
+// GPU, at up to the 200k live particles the game should handle at 60 Hz.
+//
+// Each frame moves every particle, culls them to a screen, and draws the
+// visible ones from a texture array through QuadRenderer::draw_layers(), as
+// particles::plugin does, then renders & commits on sokol-gfx's dummy
+// backend.  Particles are spawned over a screen four times wider than the
+// one drawn, so about a quarter of them are visible, and live longer than
+// the run, so the count stays fixed.  Reported per count, in ms/frame:
+//
+//   update:    the integration kernel & expiry pass
+//   cull:      finding the visible particles
+//   draw:      writing, rendering & committing their instances
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include <spdlog/spdlog.h>
+#include "particles/storage.hpp"
+#include "render/quad_renderer.hpp"
+#include "thread_pool.hpp"
+
+using namespace particles;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int SCREEN_W = 320;
+constexpr int SCREEN_H = 176;
+
+/// run every count; the renderer must be gone before sg_shutdown()
+void
+bench()
+{
+    const std::vector<uint8_t> pixels(4, 0xff);
+    sg_image_desc array_desc{};
+    array_desc.type = SG_IMAGETYPE_ARRAY;
+    array_desc.width = 1;
+    array_desc.height = 1;
+    array_desc.num_slices = 1;
+    array_desc.data.subimage[0][0] = { pixels.data(), pixels.size() };
+    sg_image array = sg_make_image(&array_desc);
+
+    const Style style{ .size = { 2, 2 }, .gravity = { 0, -24 }, .frame = 0,
+        .frames = 1, .z = 0 };
+    const glm::vec4 uv{ 0, 0, 1, 1 };
+    render::QuadRenderer::View view{ glm::mat4{ 1.0f }, { 0, 0 } };
+
+    thread_pool pool(std::max(1u, std::thread::hardware_concurrency() / 2));
+    render::QuadRenderer quads(40000, 60000);
+    std::vector<uint32_t> visible;
+
+    std::printf("%d threads\n\n", static_cast<int>(pool.size()));
+    std::printf("%8s %8s  %8s %8s %8s %8s\n", "live", "drawn", "update",
+        "cull", "draw", "total");
+    for (uint32_t count : { 50000, 100000, 200000 }) {
+        Storage storage(count);
+        storage.spawn({ { -SCREEN_W * 1.5f, 0 }, count, {
+                .style = 0,
+                .rate = 0,
+                .lifetime = 1000,
+                .velocity = { 0, 0 },
+                .spread = 8,
+                .area = { SCREEN_W * 4.0f, SCREEN_H },
+            } }, style);
+
+        std::chrono::duration<double> update{}, cull{}, draw{};
+        int frames = 0;
+        for (; update + cull + draw < std::chrono::milliseconds(250)
+                || frames < 3; frames++) {
+            auto start = clock_type::now();
+            storage.update(pool, 1 / 60.0f);
+            auto updated = clock_type::now();
+            storage.visible(pool, { -style.size.x, -style.size.y },
+                { SCREEN_W, SCREEN_H }, visible);
+            auto culled = clock_type::now();
+
+            quads.set_origin({ 0, 0 });
+            quads.set_layers(array);
+            quads.draw_layers(pool, visible.size(), [&](size_t i) {
+                return render::QuadRenderer::LayerQuad{
+                    storage.pos(visible[i]), style.size, 0, uv, 0 };
+            });
+            sg_pass_action pass{};
+            sg_begin_default_pass(&pass, SCREEN_W, SCREEN_H);
+            quads.render(view);
+            sg_end_pass();
+            sg_commit();
+            quads.clear();
+            auto drawn = clock_type::now();
+
+            // the first frame grows the renderer's buffers; skip it
+            if (frames > 0) {
+                update += updated - start;
+                cull += culled - updated;
+                draw += drawn - culled;
+            }
+        }
+
+        double n = (frames - 1) / 1000.0;
+        std::printf("%8u %8zu  %8.3f %8.3f %8.3f %8.3f\n", count,
+            visible.size(), update.count() / n, cull.count() / n,
+            draw.count() / n, (update + cull + draw).count() / n);
+    }
+    sg_destroy_image(array);
+}
+
+} // namespace
+
+int
+main()
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    sg_desc desc{};
+    desc.buffer_pool_size = 1024;
+    sg_setup(&desc);
+    bench();
+    sg_shutdown();
+    return 0;
+}
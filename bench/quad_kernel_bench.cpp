@@ -0,0 +1,152 @@
+// Expanding quads into vertices & indices on the CPU: the per-quad path
+// QuadRenderer::draw_rect() used to take for every quad, against the batched
+// quad_kernel functions behind draw_rects().
+//
+// Nothing is uploaded; only the expansion into CPU memory is measured.  The
+// per-quad path pushes onto vectors like Buffer does, the kernels write into
+// preallocated output like draw_rects() does.  Every kernel's output is
+// checked against the per-quad path before it is timed.
+//
+// Counts stop at the most quads a single batch's 16-bit indices can reach.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+#include "render/quad_kernel.hpp"
+
+using namespace render;
+using Vertex = QuadRenderer::Vertex;
+
+namespace {
+
+struct Rects {
+    std::vector<glm::vec2> pos;
+    std::vector<glm::vec2> size;
+    std::vector<glm::vec4> uv;
+};
+
+// sprites scattered over a screen around the origin, from an atlas page
+Rects
+make_rects(size_t count)
+{
+    Rects r;
+    for (size_t i = 0; i < count; i++) {
+        r.pos.push_back({ static_cast<float>((i * 37) % 1920) + 0.25f,
+            static_cast<float>((i * 53) % 1080) + 0.5f });
+        r.size.push_back({ 16.0f + i % 3 * 16, 16.0f + i % 2 * 16 });
+        r.uv.push_back({ (i % 32) / 32.0f, (i % 16) / 16.0f, 1 / 32.0f,
+            1 / 16.0f });
+    }
+    return r;
+}
+
+// draw_rect()'s expansion, minus the batching
+void
+per_quad(const Rects& r, glm::vec2 origin, float slot,
+    std::vector<Vertex>& vertices, std::vector<uint16_t>& indices)
+{
+    static const glm::vec3 quad[] = {
+        {  0.0f,  0.0f, 1.0f },
+        {  1.0f,  0.0f, 1.0f },
+        {  1.0f,  1.0f, 1.0f },
+        {  0.0f,  1.0f, 1.0f },
+    };
+    for (size_t q = 0; q < r.pos.size(); q++) {
+        glm::vec2 pos = r.pos[q] - origin, size = r.size[q];
+        glm::mat3 transform{
+            { size.x, 0.0f, 0.0f },
+            { 0.0f, size.y, 0.0f },
+            { pos.x, pos.y, 1.0f },
+        };
+        glm::vec2 uv_pos{ r.uv[q].x, r.uv[q].y };
+        glm::vec2 uv_size{ r.uv[q].z, r.uv[q].w };
+        uint16_t base = vertices.size();
+        for (int i = 0; i < 4; i++) {
+            vertices.push_back({
+                    transform * quad[i],
+                    slot,
+                    uv_pos + glm::vec2(quad[i]) * uv_size,
+                    {255, 255, 255, 255},
+                });
+        }
+        indices.insert(indices.end(), {
+                (uint16_t)base, (uint16_t)(base + 1), (uint16_t)(base + 2),
+                (uint16_t)base, (uint16_t)(base + 3), (uint16_t)(base + 2),
+            });
+    }
+}
+
+// seconds per frame of fn, averaged over enough frames to take a while
+template <typename F>
+double
+measure(F fn)
+{
+    using clock = std::chrono::steady_clock;
+    fn();   // warm up
+    size_t frames = 0;
+    auto start = clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed.count() < 0.25) {
+        fn();
+        frames++;
+        elapsed = clock::now() - start;
+    }
+    return elapsed.count() / frames;
+}
+
+} // namespace
+
+int
+main()
+{
+    const glm::vec2 origin{ 960, 540 };
+    const float slot = 1;
+
+    std::vector<quad_kernel::Expand> kernels{ quad_kernel::expand_scalar };
+#ifdef QUAD_KERNEL_X86
+    kernels.push_back(quad_kernel::expand_sse2);
+    if (quad_kernel::best() == quad_kernel::expand_avx2) {
+        kernels.push_back(quad_kernel::expand_avx2);
+    }
+#endif
+    std::printf("best kernel: %s\n\n", quad_kernel::name(quad_kernel::best()));
+
+    std::printf("%-10s %8s  %12s  %8s\n", "path", "quads", "quads/s",
+        "speedup");
+    for (size_t count : { 100, 1000, 16384 }) {
+        Rects rects = make_rects(count);
+
+        std::vector<Vertex> ref_v;
+        std::vector<uint16_t> ref_i;
+        double base = measure([&] {
+            ref_v.clear();
+            ref_i.clear();
+            per_quad(rects, origin, slot, ref_v, ref_i);
+        });
+        std::printf("%-10s %8zu  %12.0f  %7.2fx\n", "per-quad", count,
+            count / base, 1.0);
+
+        std::vector<Vertex> v(count * 4);
+        std::vector<uint16_t> i(count * 6);
+        for (auto expand : kernels) {
+            auto run = [&] {
+                expand(rects.pos.data(), rects.size.data(), rects.uv.data(),
+                    count, origin, slot, 0, v.data(), i.data());
+            };
+            run();
+            if (std::memcmp(v.data(), ref_v.data(), v.size() * sizeof(Vertex))
+                || std::memcmp(i.data(), ref_i.data(),
+                    i.size() * sizeof(uint16_t))) {
+                std::fprintf(stderr, "%s: output differs from per-quad path\n",
+                    quad_kernel::name(expand));
+                return 1;
+            }
+            double t = measure(run);
+            std::printf("%-10s %8zu  %12.0f  %7.2fx\n",
+                quad_kernel::name(expand), count, count / t, base / t);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+// Throughput of QuadRenderer & LineRenderer on the CPU, without a window or
+// GPU.  sokol-gfx runs with the dummy backend, so everything up to the
+// buffer uploads is measured, but nothing is drawn.
+//
+// For each workload & quad count, frames of synthetic sprites are drawn,
+// sorted into runs by texture like the render queue produces, then
+// rendered & committed.  Reported per workload:
+//
+//   quads/s:       quads (or line rects) drawn & rendered per second
+//   bytes/frame:   vertex & index bytes uploaded per frame, from FrameStats
+//   allocs/frame:  heap allocations per frame, after the first
+//
+// The first frame of every run is a warm-up, which grows the CPU & GPU
+// buffers to fit; it is not counted.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include <spdlog/spdlog.h>
+#include "render/frame_stats.hpp"
+#include "render/line_renderer.hpp"
+#include "render/quad_renderer.hpp"
+#include "thread_pool.hpp"
+
+using namespace render;
+
+// count every heap allocation made by the process
+static std::atomic<size_t> allocations{ 0 };
+
+void*
+operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+constexpr int SCREEN_W = 320;
+constexpr int SCREEN_H = 176;
+
+struct Result {
+    double quads_per_sec;
+    uint64_t bytes;
+    double allocs;
+};
+
+/// run `frame` until at least a quarter second has passed; the first call is
+/// a warm-up, and not counted
+Result
+run(size_t quads, const FrameStats& stats, const std::function<void()>& frame)
+{
+    frame();
+
+    int frames = 0;
+    size_t allocs = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        frame();
+        frames++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.25 || frames < 3);
+
+    const auto& c = stats.last();
+    return {
+        quads * frames / elapsed.count(),
+        c.vertex_bytes + c.index_bytes,
+        static_cast<double>(allocations.load() - allocs) / frames,
+    };
+}
+
+void
+report(const char* name, size_t quads, size_t textures, const Result& r)
+{
+    std::printf("%-12s %8zu %4zu  %12.0f  %12llu  %8.1f\n", name, quads,
+        textures, r.quads_per_sec, static_cast<unsigned long long>(r.bytes),
+        r.allocs);
+}
+
+/// start a frame the renderers can draw into
+void
+begin_frame()
+{
+    sg_pass_action pass{};
+    sg_begin_default_pass(&pass, SCREEN_W, SCREEN_H);
+}
+
+void
+end_frame()
+{
+    sg_end_pass();
+    sg_commit();
+}
+
+/// run every workload; the renderers must be gone before sg_shutdown()
+void
+bench()
+{
+    FrameStats stats;
+
+    // 1x1 textures for the sprites to use
+    std::vector<sg_image> images;
+    for (int i = 0; i < 16; i++) {
+        sg_image_desc image_desc{};
+        image_desc.width = 1;
+        image_desc.height = 1;
+        image_desc.data.subimage[0][0] = { "\xff\xff\xff\xff", 4 };
+        images.push_back(sg_make_image(&image_desc));
+    }
+
+    // and the same as the layers of a texture array
+    const std::vector<uint8_t> layer_pixels(16 * 4, 0xff);
+    sg_image_desc array_desc{};
+    array_desc.type = SG_IMAGETYPE_ARRAY;
+    array_desc.width = 1;
+    array_desc.height = 1;
+    array_desc.num_slices = 16;
+    array_desc.data.subimage[0][0] = { layer_pixels.data(),
+        layer_pixels.size() };
+    sg_image array = sg_make_image(&array_desc);
+
+    // scatter the quads over a screen, and sort them into runs by texture
+    const glm::vec4 uv{ 0, 0, 1, 1 };
+    auto quad = [&](size_t i, size_t count, size_t textures) {
+        glm::vec2 pos{ static_cast<float>((i * 37) % SCREEN_W),
+            static_cast<float>((i * 53) % SCREEN_H) };
+        return QuadRenderer::Quad{ pos, { 16, 16 },
+            images[i * textures / count], uv, 0 };
+    };
+    QuadRenderer::View view{ glm::mat4{ 1.0f }, { 0, 0 } };
+
+    thread_pool pool(std::max(1u, std::thread::hardware_concurrency() / 2));
+    QuadRenderer quads(40000, 60000);
+    quads.set_layers(array);
+    LineRenderer lines(40000, 60000);
+
+    std::printf("%-12s %8s %4s  %12s  %12s  %8s\n", "workload", "quads",
+        "tex", "quads/s", "bytes/frame", "allocs");
+    for (size_t count : { 1000, 10000, 100000, 1000000 }) {
+        for (size_t textures : { 1, 4, 16 }) {
+            report("draw_rect", count, textures, run(count, stats, [&] {
+                begin_frame();
+                for (size_t i = 0; i < count; i++) {
+                    auto q = quad(i, count, textures);
+                    quads.draw_rect(q.pos, q.size, q.texture, uv);
+                }
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+
+            // the same quads as parallel arrays, drawn a texture run at a time
+            std::vector<glm::vec2> pos(count), size(count);
+            std::vector<glm::vec4> uvs(count, uv);
+            for (size_t i = 0; i < count; i++) {
+                auto q = quad(i, count, textures);
+                pos[i] = q.pos;
+                size[i] = q.size;
+            }
+            report("draw_rects", count, textures, run(count, stats, [&] {
+                begin_frame();
+                for (size_t t = 0; t < textures; t++) {
+                    size_t first = (t * count + textures - 1) / textures;
+                    size_t last = ((t + 1) * count + textures - 1) / textures;
+                    quads.draw_rects(images[t], {
+                        std::span(pos).subspan(first, last - first),
+                        std::span(size).subspan(first, last - first),
+                        std::span(uvs).subspan(first, last - first) });
+                }
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+
+            report("draw_sprite", count, textures, run(count, stats, [&] {
+                begin_frame();
+                for (size_t i = 0; i < count; i++) {
+                    auto q = quad(i, count, textures);
+                    quads.draw_sprite(q.pos, q.size, q.texture, uv);
+                }
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+
+            report("draw_sprites", count, textures, run(count, stats, [&] {
+                begin_frame();
+                quads.draw_sprites(pool, count,
+                    [&](size_t i) { return quad(i, count, textures); });
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+
+            report("draw_layers", count, textures, run(count, stats, [&] {
+                begin_frame();
+                quads.draw_layers(pool, count, [&](size_t i) {
+                    auto q = quad(i, count, textures);
+                    return QuadRenderer::LayerQuad{ q.pos, q.size,
+                        static_cast<uint16_t>(i * textures / count), uv, 0 };
+                });
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+
+            // same again, through the depth tested opaque pass
+            report("draw_opaque", count, textures, run(count, stats, [&] {
+                begin_frame();
+                quads.draw_opaque_layers(pool, count, [&](size_t i) {
+                    auto q = quad(i, count, textures);
+                    return QuadRenderer::LayerQuad{ q.pos, q.size,
+                        static_cast<uint16_t>(i * textures / count), uv, 0 };
+                });
+                quads.render(view);
+                end_frame();
+                quads.clear();
+            }));
+        }
+    }
+
+    // line indices are 16-bit, and a rect is four vertices
+    for (size_t count : { 1000, 10000, 16000 }) {
+        report("line_rect", count, 0, run(count, stats, [&] {
+            begin_frame();
+            for (size_t i = 0; i < count; i++) {
+                auto q = quad(i, count, 1);
+                lines.draw_rect(q.pos, q.size, { 255, 0, 0, 255 });
+            }
+            lines.render(glm::mat4{ 1.0f });
+            end_frame();
+            lines.clear();
+        }));
+    }
+}
+
+} // namespace
+
+int
+main()
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    sg_desc desc{};
+    desc.buffer_pool_size = 1024;
+    sg_setup(&desc);
+    bench();
+    sg_shutdown();
+    return 0;
+}
+
@@ -0,0 +1,342 @@
+// Replay a render capture through QuadRenderer & LineRenderer in a loop, for
+// profiling the renderers on real frames.
+//
+// Captures are written by the game with --capture=<path>, or the "capture 60
+// frames" button in the render stats window.  Every quad, sprite & line in a
+// captured frame is drawn again through the same calls the game made, with a
+// blank stand-in of the same size for each texture, then rendered with the
+// captured projections & pass action.
+//
+// render_replay runs on sokol-gfx's dummy backend, so only the CPU side is
+// measured; render_replay_gl (macOS only) draws the frames in a window with
+// the GL backend.
+//
+// usage: render_replay <capture> [loops]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include <spdlog/spdlog.h>
+#include "render/capture.hpp"
+#include "render/frame_stats.hpp"
+#include "render/line_renderer.hpp"
+#include "render/quad_renderer.hpp"
+
+#ifdef REPLAY_GL
+#include <sokol_app.h>
+#include <sokol_glue.h>
+#endif
+
+using namespace render;
+
+namespace {
+
+class Replay {
+public:
+    /// read every frame of a capture into memory
+    bool load(const char* path);
+
+    /// create the renderers & stand-in textures; sokol-gfx must be set up
+    void init();
+
+    /// release everything created by init(), before sg_shutdown()
+    void cleanup();
+
+    /// draw the next captured frame; returns false once every loop is done
+    bool step(int width, int height);
+
+    void report() const;
+
+    inline const capture::Frame::Header& header() const {
+        return m_frames.front().header;
+    }
+
+    size_t loops{ 100 };
+
+private:
+    void draw(const capture::Frame&, int width, int height);
+
+    std::vector<capture::Frame> m_frames{};
+    std::unordered_map<uint32_t, sg_image> m_images{};  // by captured id
+    std::unordered_map<uint32_t, sg_image> m_arrays{};  // for draw_layer()
+    std::unique_ptr<FrameStats> m_stats{};
+    std::unique_ptr<QuadRenderer> m_quads{};
+    std::unique_ptr<LineRenderer> m_lines{};
+    size_t m_next{ 0 };     // frame to draw next, across all loops
+    size_t m_quads_drawn{ 0 };
+    std::chrono::duration<double> m_total{};
+    std::chrono::duration<double> m_min{ std::chrono::hours(1) };
+    std::chrono::duration<double> m_max{};
+};
+
+bool
+Replay::load(const char* path)
+{
+    capture::Reader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    capture::Frame frame;
+    while (reader.read(frame)) {
+        m_frames.push_back(std::move(frame));
+    }
+    if (m_frames.empty()) {
+        std::fprintf(stderr, "%s: no frames\n", path);
+        return false;
+    }
+    return true;
+}
+
+void
+Replay::init()
+{
+    m_stats = std::make_unique<FrameStats>();
+    m_quads = std::make_unique<QuadRenderer>(40000, 60000);
+    m_lines = std::make_unique<LineRenderer>(40000, 60000);
+
+    for (const auto& frame : m_frames) {
+        for (const auto& t : frame.textures) {
+            if (m_images.contains(t.id)) {
+                continue;
+            }
+            int w = std::max(t.width, 1), h = std::max(t.height, 1);
+            std::vector<uint8_t> pixels(w * h * 4, 0xff);
+            sg_image_desc desc{};
+            desc.width = w;
+            desc.height = h;
+            desc.data.subimage[0][0] = { pixels.data(), pixels.size() };
+            m_images[t.id] = sg_make_image(&desc);
+        }
+    }
+
+    // texture arrays need as many layers as the highest one drawn
+    std::unordered_map<uint32_t, std::pair<capture::Texture, int>> arrays;
+    for (const auto& frame : m_frames) {
+        for (const auto* quads : { &frame.layers, &frame.opaque }) {
+            for (const auto& q : *quads) {
+                const auto& t = frame.textures[frame.header.layer_texture];
+                auto& [texture, layers] = arrays[t.id];
+                texture = t;
+                layers = std::max(layers, static_cast<int>(q.texture) + 1);
+            }
+        }
+    }
+    for (const auto& [id, array] : arrays) {
+        const auto& [t, layers] = array;
+        int w = std::max(t.width, 1), h = std::max(t.height, 1);
+        std::vector<uint8_t> pixels(w * h * 4 * layers, 0xff);
+        sg_image_desc desc{};
+        desc.type = SG_IMAGETYPE_ARRAY;
+        desc.width = w;
+        desc.height = h;
+        desc.num_slices = layers;
+        desc.data.subimage[0][0] = { pixels.data(), pixels.size() };
+        m_arrays[id] = sg_make_image(&desc);
+    }
+}
+
+void
+Replay::cleanup()
+{
+    m_quads.reset();
+    m_lines.reset();
+    for (auto& [id, image] : m_images) {
+        sg_destroy_image(image);
+    }
+    m_images.clear();
+    for (auto& [id, image] : m_arrays) {
+        sg_destroy_image(image);
+    }
+    m_arrays.clear();
+}
+
+void
+Replay::draw(const capture::Frame& frame, int width, int height)
+{
+    const auto& h = frame.header;
+    auto image = [&](const capture::Quad& q) {
+        return m_images.at(frame.textures[q.texture].id);
+    };
+    glm::vec2 origin{ h.origin };
+
+    m_quads->set_origin(h.origin);
+    for (const auto& q : frame.rects) {
+        m_quads->draw_rect(origin + glm::vec2(q.pos), glm::vec2(q.size),
+            image(q), q.uv);
+    }
+    for (const auto& q : frame.sprites) {
+        m_quads->draw_sprite(origin + glm::vec2(q.pos), glm::vec2(q.size),
+            image(q), q.uv, q.z);
+    }
+    if (!frame.layers.empty() || !frame.opaque.empty()) {
+        m_quads->set_layers(
+            m_arrays.at(frame.textures[h.layer_texture].id));
+    }
+    for (const auto& q : frame.layers) {
+        m_quads->draw_layer(origin + glm::vec2(q.pos), glm::vec2(q.size),
+            static_cast<uint16_t>(q.texture), q.uv, q.z);
+    }
+    for (const auto& q : frame.opaque) {
+        m_quads->draw_opaque_layer(origin + glm::vec2(q.pos),
+            glm::vec2(q.size), static_cast<uint16_t>(q.texture), q.uv, q.z);
+    }
+    for (const auto& l : frame.lines) {
+        m_lines->draw_seg(l.a, l.b, l.color);
+    }
+
+    sg_pass_action pass{};
+    pass.colors[0].action = SG_ACTION_CLEAR;
+    pass.colors[0].value = { h.clear.r, h.clear.g, h.clear.b, h.clear.a };
+    sg_begin_default_pass(&pass, width, height);
+    m_quads->render({ h.quad_proj, h.camera });
+    m_lines->render(h.line_proj);
+    sg_end_pass();
+    sg_commit();
+
+    m_quads->clear();
+    m_lines->clear();
+}
+
+bool
+Replay::step(int width, int height)
+{
+    if (m_next >= m_frames.size() * loops) {
+        return false;
+    }
+    const auto& frame = m_frames[m_next % m_frames.size()];
+
+    auto start = std::chrono::steady_clock::now();
+    draw(frame, width, height);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    m_total += elapsed;
+    m_min = std::min(m_min, elapsed);
+    m_max = std::max(m_max, elapsed);
+    m_quads_drawn += frame.rects.size() + frame.sprites.size()
+        + frame.layers.size() + frame.opaque.size();
+    m_next++;
+    return true;
+}
+
+void
+Replay::report() const
+{
+    if (m_next == 0) {
+        return;
+    }
+    size_t rects = 0, sprites = 0, layers = 0, opaque = 0, lines = 0;
+    for (const auto& frame : m_frames) {
+        rects += frame.rects.size();
+        sprites += frame.sprites.size();
+        layers += frame.layers.size();
+        opaque += frame.opaque.size();
+        lines += frame.lines.size();
+    }
+    double n = m_frames.size();
+    const auto& c = m_stats->last();
+
+    std::printf("%zu frames x %zu loops\n", m_frames.size(), loops);
+    std::printf("per frame: %.0f rects, %.0f sprites, %.0f layers, %.0f"
+                " opaque, %.0f lines, %zu textures\n", rects / n, sprites / n,
+        layers / n, opaque / n, lines / n, m_images.size());
+    std::printf("cpu ms/frame: avg %.3f, min %.3f, max %.3f\n",
+        m_total.count() * 1000 / m_next, m_min.count() * 1000,
+        m_max.count() * 1000);
+    std::printf("quads/s: %.0f\n", m_quads_drawn / m_total.count());
+    std::printf("last frame: %u draws, %llu vertex & index bytes\n", c.draws,
+        static_cast<unsigned long long>(c.vertex_bytes + c.index_bytes));
+}
+
+int
+usage(const char* name)
+{
+    std::fprintf(stderr, "usage: %s <capture> [loops]\n", name);
+    return 1;
+}
+
+} // namespace
+
+#ifdef REPLAY_GL
+
+sapp_desc
+sokol_main(int argc, char* argv[])
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    static Replay replay;
+    if (argc < 2) {
+        std::exit(usage(argv[0]));
+    }
+    if (!replay.load(argv[1])) {
+        std::exit(1);
+    }
+    if (argc > 2) {
+        replay.loops = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    return {
+        .width = replay.header().width,
+        .height = replay.header().height,
+        .user_data = &replay,
+        .init_userdata_cb = [](void* data) {
+            sg_desc desc{};
+            desc.buffer_pool_size = 1024;
+            desc.context = sapp_sgcontext();
+            sg_setup(&desc);
+            static_cast<Replay*>(data)->init();
+        },
+        .frame_userdata_cb = [](void* data) {
+            if (!static_cast<Replay*>(data)->step(sapp_width(),
+                    sapp_height())) {
+                sapp_request_quit();
+            }
+        },
+        .cleanup_userdata_cb = [](void* data) {
+            auto replay = static_cast<Replay*>(data);
+            replay->report();
+            replay->cleanup();
+            sg_shutdown();
+        },
+        .window_title = "render_replay",
+    };
+}
+
+#else
+
+int
+main(int argc, char* argv[])
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    if (argc < 2) {
+        return usage(argv[0]);
+    }
+    Replay replay;
+    if (!replay.load(argv[1])) {
+        return 1;
+    }
+    if (argc > 2) {
+        replay.loops = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    sg_desc desc{};
+    desc.buffer_pool_size = 1024;
+    sg_setup(&desc);
+    replay.init();
+    int width = replay.header().width, height = replay.header().height;
+    while (replay.step(width, height)) {
+    }
+    replay.report();
+    replay.cleanup();
+    sg_shutdown();
+    return 0;
+}
+
+#endif
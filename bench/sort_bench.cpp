@@ -0,0 +1,134 @@
+// Compare ordering sprites for drawing by sorting the ECS Translate pool
+// (entt::insertion_sort, as render::insert_sort_sprites did, and std::sort)
+// against building & radix sorting a render::RenderQueue.
+//
+// Two cases are timed for each sprite count:
+//   moved:    sorted last frame, then 10% of sprites moved a little in y
+//   shuffled: no useful order at all, like the first frame after a load
+//
+// Insertion sort is skipped for large shuffled sets; it is O(n^2) there.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+#include <entt/entt.hpp>
+#include "render/render_queue.hpp"
+
+using render::RenderQueue;
+
+namespace {
+
+// stand-in for render::Translate without the glm & chipmunk dependencies
+struct Translate {
+    float x, y;
+    int z;
+};
+
+bool
+draw_order(const Translate& lhs, const Translate& rhs)
+{
+    return lhs.z == rhs.z ? lhs.y < rhs.y : lhs.z < rhs.z;
+}
+
+std::vector<Translate>
+make_sprites(size_t count, bool shuffled, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos(0, 10000);
+    std::uniform_real_distribution<float> step(-2, 2);
+    std::vector<Translate> sprites(count);
+    for (auto& s : sprites) {
+        s = { pos(rng), pos(rng), static_cast<int>(rng() % 3) };
+    }
+    if (shuffled) {
+        return sprites;
+    }
+
+    std::sort(sprites.begin(), sprites.end(), draw_order);
+    for (size_t i = 0; i < count / 10; i++) {
+        sprites[rng() % count].y += step(rng);
+    }
+    return sprites;
+}
+
+/// best of `runs` timings of `fn`, in milliseconds; `setup` is untimed
+double
+time_ms(int runs, const std::function<void()>& setup,
+    const std::function<void()>& fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> d =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, d.count());
+    }
+    return best;
+}
+
+void
+bench(size_t count, bool shuffled)
+{
+    std::mt19937 rng(count);
+    auto sprites = make_sprites(count, shuffled, rng);
+    constexpr int runs = 5;
+
+    entt::registry ecs;
+    std::vector<entt::entity> entities(count);
+    ecs.create(entities.begin(), entities.end());
+    auto fill = [&] {
+        ecs.clear<Translate>();
+        for (size_t i = 0; i < count; i++) {
+            ecs.emplace<Translate>(entities[i], sprites[i]);
+        }
+    };
+
+    double insertion = -1;
+    if (!shuffled || count <= 50000) {
+        insertion = time_ms(runs, fill, [&] {
+            ecs.sort<Translate>(draw_order, entt::insertion_sort{});
+        });
+    }
+
+    double std_sort =
+        time_ms(runs, fill, [&] { ecs.sort<Translate>(draw_order); });
+
+    RenderQueue queue;
+    queue.reserve(count);
+    double radix = time_ms(runs, [] {}, [&] {
+        queue.clear();
+        auto view = ecs.view<const Translate>();
+        uint32_t i = 0;
+        for (auto [e, tsl] : view.each()) {
+            queue.push(RenderQueue::key(tsl.z, tsl.y, 1), i++);
+        }
+        queue.sort();
+    });
+
+    printf("%-8s %7zu  ", shuffled ? "shuffled" : "moved", count);
+    if (insertion < 0) {
+        printf("%14s", "skipped");
+    } else {
+        printf("%11.3f ms", insertion);
+    }
+    printf("  %11.3f ms  %11.3f ms\n", std_sort, radix);
+}
+
+} // namespace
+
+int
+main()
+{
+    printf("%-8s %7s  %14s  %14s  %14s\n", "case", "sprites",
+        "insertion_sort", "std::sort", "RenderQueue");
+    for (bool shuffled : { false, true }) {
+        for (size_t count : { 10000, 50000, 100000, 500000 }) {
+            bench(count, shuffled);
+        }
+    }
+    return 0;
+}
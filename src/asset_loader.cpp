@@ -5,6 +5,7 @@
 #include "components.hpp"
 #include "image.hpp"
 #include "log.hpp"
+#include "particles/plugin.hpp"
 #include "physics.hpp"
 #include "physics/body.hpp"
 #include "physics/collision_type.hpp"
@@ -17,10 +18,52 @@ using namespace entt::literals;
 bool
 asset_loader::load_scene(entt::registry& ecs)
 {
-    m_map_tileset = Image{ m_asset_dir / "map.png"};
-    assert(m_map_tileset.valid());
-    m_mob_tileset = Image{ m_asset_dir / "mob.png"};
-    assert(m_mob_tileset.valid());
+    // pack the tilesets into the sprite atlas
+    m_atlas.reset();
+    m_layers.reset();
+    {
+        Image map{ m_asset_dir / "map.png" };
+        assert(map.valid());
+        m_map_tileset = m_atlas.add(map);
+
+        Image mob{ m_asset_dir / "mob.png" };
+        assert(mob.valid());
+        m_mob_tileset = m_atlas.add(mob);
+    }
+    m_atlas.build();
+
+    // the pages are all the same size, so they also make a texture array
+    for (size_t i = 0; i < m_atlas.pages(); i++) {
+        m_layers.add(m_atlas.page(i));
+    }
+    m_layers.build();
+
+    // register the frames the scene uses
+    auto& frames = ecs.ctx().get<render::SpriteFrames>();
+    frames.clear();
+    frames.set_layers(m_layers.sg_image());
+    auto frame = [&](const Atlas::Region& r, int x, int y) {
+        return frames.add(m_atlas.sg_image(r),
+            m_atlas.crop_uv(r, x, y, 16, 16), static_cast<uint16_t>(r.page),
+            m_atlas.opaque(r, x, y, 16, 16));
+    };
+    render::FrameId player_frame = frame(m_mob_tileset, 17, 5 * 16 + 5);
+    render::FrameId wall_frame = frame(m_map_tileset, 17 * 15, 17 * 8);
+    render::FrameId grass_frames[] = {
+        frame(m_map_tileset, 17 * 5, 0),
+        frame(m_map_tileset, 17 * 5, 17),
+    };
+
+    // particle styles use the frames, so they're replaced along with them
+    auto& particles = ecs.ctx().get<particles::plugin>();
+    particles.clear();
+    particles::StyleId dust = particles.add_style({
+        .size = { 2, 2 },
+        .gravity = { 0, -24 },
+        .frame = wall_frame,
+        .frames = 1,
+        .z = 1,
+    });
 
     // create the player
     entt::entity p = ecs.create();
@@ -28,16 +71,20 @@ asset_loader::load_scene(entt::registry& ecs)
     ecs.emplace<HumanDescription>(p, "test player", "");
     ecs.emplace<render::Translate>(p, 0, 0, 1);
     ecs.emplace<render::Sprite>(p,
-        render::Sprite{
-            {16, 16},
-            m_mob_tileset.sg_image(),
-            m_mob_tileset.crop_transform(17, 5 * 16 + 5, 16, 16)
-    });
+        render::Sprite{ {16, 16}, player_frame });
     auto& body = ecs.emplace<physics::Body>(p);
     cpBodySetPosition(body, { 160, 96 });
     ecs.emplace<physics::Movable>(p, 1000.0f, 100.0f);
     auto& shape = ecs.emplace<physics::Box>(p, 15.0, 15.0, 0, p);
     cpShapeSetCollisionType(shape, physics::CT_Player);
+    particles.attach(ecs, p, {
+            .style = dust,
+            .rate = 20,
+            .lifetime = 0.5,
+            .velocity = { 0, 12 },
+            .spread = 6,
+            .area = { 16, 2 },
+        });
     ecs.ctx().emplace_as<entt::entity>("player"_hs, p);
 
     // create an immovable wall
@@ -46,11 +93,7 @@ asset_loader::load_scene(entt::registry& ecs)
     ecs.emplace<HumanDescription>(w, "wall", "immovable wall");
     ecs.emplace<render::Translate>(w, 0, 0, 1); // will be updated from body
     ecs.emplace<render::Sprite>(w,
-        render::Sprite{
-            {16, 16},
-            m_map_tileset.sg_image(),
-            m_map_tileset.crop_transform(17 * 15, 17 * 8, 16, 16)
-    });
+        render::Sprite{ {16, 16}, wall_frame });
     {
         auto& body = ecs.emplace<physics::Body>(w);
         cpBodySetType(body, CP_BODY_TYPE_STATIC);
@@ -66,19 +109,13 @@ asset_loader::load_scene(entt::registry& ecs)
         for (int x = 0; x < 21; x++) {
             entt::entity tile = ecs.create();
             ecs.emplace<Scene>(tile);
+            ecs.emplace<render::Static>(tile);
             ecs.emplace<render::Translate>(tile, x * 16 - 8, y * 16 - 8, 0);
             ecs.emplace<render::Sprite>(tile, glm::vec2{ 16, 16 },
-                m_map_tileset.sg_image(),
-                m_map_tileset.crop_transform(
-                    17 * 5, (rand() % 2) * 17, 16, 16));
+                grass_frames[rand() % 2]);
         }
     }
 
-    // y-z sort all of the things we're gonna render
-    ecs.sort<render::Translate>([](const auto& lhs, const auto& rhs) {
-        return lhs.z == rhs.z ? lhs.v.y < rhs.v.y : lhs.z < rhs.z;
-    });
-
     return true;
 }
 
@@ -94,6 +131,6 @@ asset_loader::clear_scene(entt::registry& ecs)
 void
 asset_loader::cleanup()
 {
-    m_map_tileset.reset();
-    m_mob_tileset.reset();
+    m_layers.reset();
+    m_atlas.reset();
 }
@@ -2,7 +2,8 @@
 
 #include <filesystem>
 #include <entt/fwd.hpp>
-#include "image.hpp"
+#include "atlas.hpp"
+#include "texture_array.hpp"
 
 struct Scene {};
 
@@ -18,6 +19,8 @@ public:
 
 private:
     std::filesystem::path m_asset_dir;
-    Image m_map_tileset{};
-    Image m_mob_tileset{};
+    Atlas m_atlas{ "sprites" };
+    TextureArray m_layers{ "sprite layers" };   // the atlas pages
+    Atlas::Region m_map_tileset{};
+    Atlas::Region m_mob_tileset{};
 };
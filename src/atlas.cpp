@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include "atlas.hpp"
+#include "log.hpp"
+
+// gap left between packed images, so filtering never samples a neighbour
+static constexpr int PADDING = 1;
+
+// every Image is RGBA
+static constexpr int BPP = 4;
+
+bool
+Atlas::pack(Page& page, int w, int h, Region& region)
+{
+    // find the span of the skyline where the image would sit lowest
+    size_t best = SIZE_MAX;
+    int best_y = INT_MAX, best_w = INT_MAX;
+    for (size_t i = 0; i < page.skyline.size(); i++) {
+        int x = page.skyline[i].x;
+        if (x + w > m_page_size) {
+            break;
+        }
+
+        // the image rests on the highest skyline under it
+        int y = 0, remain = w;
+        for (size_t j = i; remain > 0; j++) {
+            y = std::max(y, page.skyline[j].y);
+            remain -= page.skyline[j].w;
+        }
+        if (y + h > m_page_size) {
+            continue;
+        }
+        if (y < best_y || (y == best_y && page.skyline[i].w < best_w)) {
+            best   = i;
+            best_y = y;
+            best_w = page.skyline[i].w;
+        }
+    }
+    if (best == SIZE_MAX) {
+        return false;
+    }
+
+    region.x = page.skyline[best].x;
+    region.y = best_y;
+    region.w = w;
+    region.h = h;
+
+    // raise the skyline over the image, and trim the spans it covers
+    Skyline top{ region.x, best_y + h, w };
+    page.skyline.insert(page.skyline.begin() + best, top);
+    size_t i = best + 1;
+    while (i < page.skyline.size()) {
+        auto& s = page.skyline[i];
+        int overlap = top.x + top.w - s.x;
+        if (overlap <= 0) {
+            break;
+        }
+        if (overlap < s.w) {
+            s.x += overlap;
+            s.w -= overlap;
+            break;
+        }
+        page.skyline.erase(page.skyline.begin() + i);
+    }
+
+    return true;
+}
+
+Atlas::Region
+Atlas::add(const Image& image)
+{
+    assert(image.valid());
+    int w = image.width() + PADDING;
+    int h = image.height() + PADDING;
+    assert(w <= m_page_size && h <= m_page_size && "image larger than page");
+
+    Region region;
+    for (region.page = 0; region.page < m_pages.size(); region.page++) {
+        if (pack(m_pages[region.page], w, h, region)) {
+            break;
+        }
+    }
+    if (region.page == m_pages.size()) {
+        auto& page = m_pages.emplace_back();
+        page.skyline.push_back({ 0, 0, m_page_size });
+        page.pixels.resize(m_page_size * m_page_size * BPP);
+        [[maybe_unused]] bool packed = pack(page, w, h, region);
+        assert(packed);
+    }
+    region.w -= PADDING;
+    region.h -= PADDING;
+
+    // copy the image into the page a row at a time
+    auto& page = m_pages[region.page];
+    auto* src  = static_cast<const uint8_t*>(image.data());
+    size_t row = region.w * BPP;
+    for (int y = 0; y < region.h; y++) {
+        memcpy(&page.pixels[((region.y + y) * m_page_size + region.x) * BPP],
+            src + y * row, row);
+    }
+
+    log_debug("atlas {}: packed {} at page {}, ({}, {})", m_label,
+        image.label(), region.page, region.x, region.y);
+    return region;
+}
+
+bool
+Atlas::opaque(const Region& r, int x, int y, int w, int h) const
+{
+    assert(x >= 0 && y >= 0 && x + w <= r.w && y + h <= r.h);
+    const auto& pixels = m_pages[r.page].pixels;
+    for (int row = r.y + y; row < r.y + y + h; row++) {
+        for (int col = r.x + x; col < r.x + x + w; col++) {
+            if (pixels[(row * m_page_size + col) * BPP + 3] != 0xff) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void
+Atlas::build()
+{
+    for (size_t i = 0; i < m_pages.size(); i++) {
+        auto& page = m_pages[i];
+        page.image = Image(fmt::format("{}[{}]", m_label, i),
+            page.pixels.data(), page.pixels.size(), m_page_size,
+            m_page_size);
+    }
+}
+
+void
+Atlas::reset()
+{
+    m_pages.clear();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include "image.hpp"
+
+/// sprite sheets packed into a few large textures
+///
+/// Images are packed into pages at load time with add(), which returns the
+/// Region of the page the image was copied into.  Once all images have been
+/// added, build() creates a texture for each page.  Sprites are then drawn
+/// from the page textures, using crop_transform() in place of
+/// Image::crop_transform(), so sprites from different sheets share a single
+/// texture binding.
+///
+/// Packing uses a bottom-left skyline, which is simple and packs the
+/// similarly sized sheets we load well.
+class Atlas {
+public:
+    /// area of an atlas page holding one packed image
+    struct Region {
+        size_t page{ 0 };
+        int x{ 0 };
+        int y{ 0 };
+        int w{ 0 };
+        int h{ 0 };
+    };
+
+    Atlas(const std::string& label, int page_size = 1024)
+        : m_label{ label }, m_page_size{ page_size } {};
+
+    /// copy an image into the atlas; image must not be larger than a page
+    Region add(const Image&);
+
+    /// create the textures for all pages
+    void build();
+
+    /// free all pages & packed images
+    void reset();
+
+    inline size_t pages() const { return m_pages.size(); }
+    inline const Image& page(size_t i) const { return m_pages[i].image; }
+    inline struct sg_image sg_image(const Region& r) const {
+        return m_pages[r.page].image.sg_image();
+    }
+
+    // return a 3x3 matrix to convert pixel (x, y) cords within the cropped
+    // region of a packed image to normalized (x, y) coords within the page.
+    inline glm::mat3 const crop_transform(
+        const Region& r, int x, int y, int w, int h) const {
+        float size = static_cast<float>(m_page_size);
+        return {
+            { w/size, 0,                     0 },  // column 0
+            { 0,      h/size,                0 },  // column 1
+            { (r.x + x)/size, (r.y + y)/size, 1 }, // column 2
+        };
+    }
+
+    // return the normalized top-left & size within the page of a cropped
+    // region of a packed image, for render::SpriteFrames
+    inline glm::vec4 const crop_uv(
+        const Region& r, int x, int y, int w, int h) const {
+        float size = static_cast<float>(m_page_size);
+        return { (r.x + x)/size, (r.y + y)/size, w/size, h/size };
+    }
+
+    /// check if every pixel in a cropped region of a packed image is fully
+    /// opaque, so it can be drawn without blending
+    bool opaque(const Region& r, int x, int y, int w, int h) const;
+
+private:
+    /// top edge of the packed area, for a span of page columns
+    struct Skyline {
+        int x;
+        int y;
+        int w;
+    };
+
+    struct Page {
+        std::vector<Skyline> skyline{};
+        std::vector<uint8_t> pixels{};
+        Image image{};
+    };
+
+    bool pack(Page&, int w, int h, Region&);
+
+    std::string m_label;
+    int m_page_size;
+    std::vector<Page> m_pages{};
+};
@@ -16,7 +16,8 @@ Image::Image(const std::filesystem::path &path)
     }
     m_label = path.string();
     m_data = std::make_unique<unsigned char *>(data);
-    make_image(bpp * width * height, width, height);
+    // stbi_load() always converts to RGBA
+    make_image(4 * width * height, width, height);
 }
 
 Image::Image(
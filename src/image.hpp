@@ -31,7 +31,7 @@ public:
     inline size_t size() const { return m_desc.data.subimage[0][0].size; }
     inline const sg_image sg_image() const { return m_image; }
     inline bool valid() const { return m_data != nullptr; }
-    inline const void * data() const { return m_data.get(); }
+    inline const void * data() const { return m_data ? *m_data : nullptr; }
 
     // return a 3x3 matrix to convert pixel  (x, y) cords within the cropped
     // texture region to normalized (x, y) coords within the whole texture.
@@ -8,7 +8,10 @@
 #include "entity_editor.hpp"
 #include "imgui.hpp"
 #include "log.hpp"
+#include "particles/plugin.hpp"
+#include "physics/rooms.hpp"
 #include "render.hpp"
+#include "sim_thread.hpp"
 #include "system.hpp"
 #include "tags.hpp"
 
@@ -75,6 +78,7 @@ plugin::init(entt::registry& ecs)
             .name       = "imgui::draw",
             .always_run = true,
             .stage      = System::Stage::imgui_draw,
+            .thread     = System::Thread::main_sync,
             .handler =
                 [](auto& ecs, auto& view, float delta) {
                     simgui_new_frame({ .width = sapp_width(),
@@ -95,7 +99,22 @@ plugin::init(entt::registry& ecs)
                         }
                         draw.draw(ecs, entity, draw);
                     }
+                },
+        });
+    ecs.emplace<HumanDescription>(
+        entity, "system: ImGui", "draw all imgui::Draw components");
 
+    // rendering is split from drawing so it can happen while the simulation
+    // thread owns the registry
+    entity = ecs.create();
+    ecs.emplace<System>(entity,
+        System::Config<>{
+            .name       = "imgui::render",
+            .always_run = true,
+            .stage      = System::Stage::imgui_render,
+            .thread     = System::Thread::main_async,
+            .handler =
+                [](auto&, float) {
                     // now render it all in one pass
                     sg_pass_action pass = {
                         .colors[0].action = SG_ACTION_DONTCARE,
@@ -106,7 +125,7 @@ plugin::init(entt::registry& ecs)
                 },
         });
     ecs.emplace<HumanDescription>(
-        entity, "system: ImGui", "render all imgui::Draw components");
+        entity, "system: ImGui render", "render the ImGui frame");
 
     // sokol debug stuff
     entity = ecs.create();
@@ -136,6 +155,8 @@ plugin::init(entt::registry& ecs)
         if (ImGui::BeginMainMenuBar()) {
             if (ImGui::BeginMenu("tools")) {
                 ImGui::MenuItem("systems", 0, &m_systems);
+                ImGui::MenuItem("render stats", 0, &m_render_stats);
+                ImGui::MenuItem("particles", 0, &m_particle_stats);
                 ImGui::MenuItem("entities", 0, &m_editor);
                 ImGui::MenuItem("ImGui Demo", 0, &m_demo);
                 if (ImGui::MenuItem("Reset Scene")) {
@@ -159,6 +180,16 @@ plugin::init(entt::registry& ecs)
         if (m_systems) {
             show_systems(ecs);
         }
+        if (m_render_stats) {
+            ImGui::Begin("Render Stats", &m_render_stats);
+            ecs.ctx().template get<render::plugin>().show_stats();
+            ImGui::End();
+        }
+        if (m_particle_stats) {
+            ImGui::Begin("Particles", &m_particle_stats);
+            ecs.ctx().template get<particles::plugin>().show_stats();
+            ImGui::End();
+        }
         if (m_editor) {
             editor.draw_editor(ecs, m_editor_entity, m_editor);
         }
@@ -190,10 +221,16 @@ plugin::show_systems(entt::registry& ecs)
         state.next_system = entt::null;
     }
 
+    auto& sim = ecs.ctx().get<sim_thread>();
+    ImGui::Text("Simulation Thread");
+    ImGui::SameLine();
+    ImGui::Checkbox("##sim-thread", &sim.enabled);
+
     if (ImGui::BeginTable(
-            "systems", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            "systems", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
         ImGui::TableSetupColumn("E", ImGuiTableColumnFlags_WidthFixed, 20.0f);
         ImGui::TableSetupColumn("A", ImGuiTableColumnFlags_WidthFixed, 20.0f);
+        ImGui::TableSetupColumn("T", ImGuiTableColumnFlags_WidthFixed, 20.0f);
         ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_WidthStretch);
         ImGui::TableSetupColumn(
             "time (ms)", ImGuiTableColumnFlags_WidthFixed, 75.0f);
@@ -214,6 +251,12 @@ plugin::show_systems(entt::registry& ecs)
             ImGui::TableNextColumn();
             ImGui::Checkbox("##always_run", &system.always_run);
             ImGui::TableNextColumn();
+            switch (system.thread) {
+            case System::Thread::simulation: ImGui::Text("S"); break;
+            case System::Thread::main_sync: ImGui::Text("M"); break;
+            case System::Thread::main_async: ImGui::Text("A"); break;
+            }
+            ImGui::TableNextColumn();
             ImGui::Text("%s", system.name);
             ImGui::TableNextColumn();
             ImGui::Text("%0.03f", system.perf.last.count() / 1000000.0);
@@ -225,6 +268,49 @@ plugin::show_systems(entt::registry& ecs)
         }
         ImGui::EndTable();
     }
+
+    auto& rooms = ecs.ctx().get<physics::Rooms>();
+    if (ImGui::CollapsingHeader("Physics Rooms")
+        && ImGui::BeginTable(
+            "rooms", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("origin", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("lod", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn(
+            "rate", ImGuiTableColumnFlags_WidthFixed, 40.0f);
+        ImGui::TableSetupColumn(
+            "bodies", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableSetupColumn(
+            "step (ms)", ImGuiTableColumnFlags_WidthFixed, 75.0f);
+        ImGui::TableHeadersRow();
+
+        for (auto& [key, room] : rooms) {
+            cpVect origin = physics::Rooms::origin(key);
+            size_t bodies = 0;
+            cpSpaceEachBody(
+                room->space,
+                [](cpBody*, void* data) { (*static_cast<size_t*>(data))++; },
+                &bodies);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f, %.0f", origin.x, origin.y);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", physics::room_lod_name[room->lod]);
+            ImGui::TableNextColumn();
+            switch (room->lod) {
+            case physics::RL_Full: ImGui::Text("1/1"); break;
+            case physics::RL_Reduced:
+                ImGui::Text("1/%u", physics::ROOM_REDUCED_INTERVAL);
+                break;
+            default: ImGui::Text("-"); break;
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", bodies);
+            ImGui::TableNextColumn();
+            ImGui::Text("%0.03f", room->perf.count() / 1000000.0);
+        }
+        ImGui::EndTable();
+    }
     ImGui::End();
 }
 
@@ -33,6 +33,8 @@ private:
 
     bool m_demo{ false }; // open imgui demo
     bool m_systems{ false }; // open systems monitor
+    bool m_render_stats{ false }; // open render stats
+    bool m_particle_stats{ false }; // open particle stats
     bool m_editor{ false }; // open entity editor
     entt::entity m_editor_entity;
     sg_imgui_t m_sg_imgui{};
@@ -59,6 +59,7 @@ plugin::init(entt::registry& ecs)
             .enabled = true,
             .always_run = true,
             .stage = System::Stage::input,
+            .thread = System::Thread::main_sync,
             .handler = handle_input,
         });
     ecs.emplace<HumanDescription>(entity,
@@ -1,4 +1,8 @@
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 #include <sokol_gfx.h>
 #include <sokol_app.h>
 #include <sokol_glue.h>
@@ -13,21 +17,37 @@
 #include "physics/collision_type.hpp"
 #include "physics/shape.hpp"
 #include "physics/debug_draw.hpp"
+#include "particles/plugin.hpp"
 #include "render.hpp"
 #include "imgui.hpp"
 #include "tags.hpp"
 #include "image.hpp"
 #include "system.hpp"
+#include "sim_thread.hpp"
+#include "thread_pool.hpp"
 #include "components.hpp"
 #include "entity_editor.hpp"
 #include "input.hpp"
 #include "asset_loader.hpp"
 
+/// path to record per-frame render stats to; set by --render-stats=<path>
+static const char *render_stats_path = nullptr;
+
+/// path to capture the first frames' render submissions to; set by
+/// --capture=<path>
+static const char *capture_path = nullptr;
+
 void
 init(void *data)
 {
     entt::registry &ecs = *static_cast<entt::registry *>(data);
     ecs.ctx().emplace<system_step_state>();
+    ecs.ctx().emplace<sim_thread>();
+
+    // the simulation's pool runs alongside the render plugin's, which takes
+    // half the cores, so it gets the rest
+    unsigned cores = std::thread::hardware_concurrency();
+    ecs.ctx().emplace<thread_pool>(std::max(1u, cores - cores / 2));
 
     entt::entity entity = ecs.create();
     ecs.emplace<System>(entity, System::Config<tags::Destroy>{
@@ -46,6 +66,7 @@ init(void *data)
     ecs.ctx().emplace<physics::plugin>(ecs);
     ecs.ctx().emplace<physics::debug_draw>(ecs);
     ecs.ctx().emplace<render::plugin>(ecs);
+    ecs.ctx().emplace<particles::plugin>(ecs);
     ecs.ctx().emplace<imgui::plugin>(ecs);
     ecs.ctx().emplace<input::plugin>();
     auto &loader = ecs.ctx().emplace<asset_loader>("resources");
@@ -60,6 +81,13 @@ init(void *data)
     ecs.ctx().get<physics::plugin>().init(ecs);
     ecs.ctx().get<physics::debug_draw>().init(ecs);
     ecs.ctx().get<render::plugin>().init(ecs);
+    if (render_stats_path) {
+        ecs.ctx().get<render::plugin>().record_stats(render_stats_path);
+    }
+    if (capture_path) {
+        ecs.ctx().get<render::plugin>().capture(capture_path);
+    }
+    ecs.ctx().get<particles::plugin>().init(ecs);
     ecs.ctx().get<imgui::plugin>().init(ecs);
     ecs.ctx().get<input::plugin>().init(ecs);
 
@@ -77,12 +105,65 @@ init(void *data)
     log_info("init done");
 }
 
+/// run a frame with the simulation systems on the simulation thread
+///
+/// main_sync systems run first, while we still own the registry.  Then the
+/// simulation tick is started, and the main_async systems render the last
+/// published snapshot alongside it.  The tick is joined at the start of the
+/// next frame.
+static void
+frame_threaded(entt::registry &ecs, sim_thread &sim, float delta)
+{
+    sim.wait();
+
+    // collect the async systems now; they can't look at the registry once the
+    // simulation is running
+    std::vector<System *> async;
+    for (auto &&[e, system] : ecs.view<System>().each()) {
+        if (!system.enabled) {
+            continue;
+        }
+        switch (system.thread) {
+        case System::Thread::main_sync:
+            system.run(system, ecs, delta);
+            break;
+        case System::Thread::main_async:
+            async.push_back(&system);
+            break;
+        case System::Thread::simulation:
+            break;
+        }
+    }
+
+    sim.start([&ecs, delta]() {
+        for (auto &&[e, system] : ecs.view<System>().each()) {
+            if (system.enabled
+                    && system.thread == System::Thread::simulation) {
+                system.run(system, ecs, delta);
+            }
+        }
+    });
+
+    for (System *system : async) {
+        system->run(*system, ecs, delta);
+    }
+}
+
 void
 frame(void *data)
 {
     entt::registry &ecs = *static_cast<entt::registry *>(data);
     float delta = sapp_frame_duration();
     system_step_state &step_state = ecs.ctx().get<system_step_state>();
+    sim_thread &sim = ecs.ctx().get<sim_thread>();
+
+    if (sim.enabled && !step_state.enabled) {
+        frame_threaded(ecs, sim, delta);
+        return;
+    }
+
+    // make sure the last threaded tick is done before we take over
+    sim.wait();
 
     if (!step_state.enabled) {
         for (auto &&[e, system] : ecs.view<System>().each()) {
@@ -133,10 +214,12 @@ cleanup(void *data)
 {
     entt::registry &ecs = *static_cast<entt::registry *>(data);
 
+    ecs.ctx().get<sim_thread>().wait();
     ecs.ctx().get<asset_loader>().cleanup();
     ecs.ctx().get<physics::plugin>().cleanup(ecs);
     ecs.ctx().get<physics::debug_draw>().cleanup(ecs);
     ecs.ctx().get<imgui::plugin>().cleanup(ecs);
+    ecs.ctx().get<particles::plugin>().cleanup(ecs);
     ecs.ctx().get<render::plugin>().cleanup(ecs);
 
     delete &ecs;
@@ -152,9 +235,21 @@ handle_input(const sapp_event *event, void *)
 
 sapp_desc
 sokol_main(int argc, char* argv[]) {
-    (void)argc; (void)argv;
     log_init();
 
+    const char *stats_arg = "--render-stats=";
+    const char *capture_arg = "--capture=";
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], stats_arg, std::strlen(stats_arg)) == 0) {
+            render_stats_path = argv[i] + std::strlen(stats_arg);
+        } else if (std::strncmp(argv[i], capture_arg,
+                       std::strlen(capture_arg)) == 0) {
+            capture_path = argv[i] + std::strlen(capture_arg);
+        } else {
+            log_warn("unknown argument: {}", argv[i]);
+        }
+    }
+
     return {
         .width = 1280,
         .height = 720,
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "render/sprite_frames.hpp"
+
+namespace particles {
+
+/// index of a Style in particles::plugin
+using StyleId = uint16_t;
+
+/// how a kind of particle looks & moves, such as sparks, dust or rain
+///
+/// Styles are shared by every particle drawn with them, and are read without
+/// locking by the simulation & main threads, so like render::SpriteFrames
+/// they must only be added while loading a scene.
+struct Style {
+    glm::vec2 size;         // on screen
+    glm::vec2 gravity;      // acceleration, in pixels/s^2
+    render::FrameId frame;  // first frame of the animation
+    uint16_t frames{ 1 };   // frames played once over a particle's life
+    int16_t z{ 0 };         // like render::Translate::z
+};
+
+/// what an emitter or a burst spawns
+struct EmitterDesc {
+    StyleId style;
+    float rate;             // particles per second; unused by bursts
+    float lifetime;         // seconds
+    glm::vec2 velocity;     // in pixels/s
+    float spread{ 0 };      // random speed added in a random direction
+    glm::vec2 area{ 0 };    // spawn anywhere in this rect from the position
+};
+
+/// pooled emitter spawning particles at an entity's render::Translate
+///
+/// Created with particles::plugin::attach(); the slot is returned to the pool
+/// when the component is removed.
+struct Emitter {
+    uint32_t id;            // slot in the plugin's emitter pool
+    glm::vec2 offset;       // from render::Translate
+};
+
+} // namespace particles
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <entt/entt.hpp>
+#include <imgui.h>
+
+#include "../components.hpp"
+#include "../log.hpp"
+#include "../render.hpp"
+#include "../render/quad_renderer.hpp"
+#include "../system.hpp"
+#include "plugin.hpp"
+
+namespace particles {
+
+plugin::plugin(entt::registry& ecs)
+{
+    log_debug("load particles plugin");
+    ecs.on_destroy<Emitter>().connect<&plugin::on_emitter_destroy>(*this);
+}
+
+void
+plugin::on_emitter_destroy(entt::registry& ecs, entt::entity e)
+{
+    m_free.push_back(ecs.get<Emitter>(e).id);
+}
+
+StyleId
+plugin::add_style(const Style& style)
+{
+    m_styles.push_back(style);
+    m_margin = glm::max(m_margin, style.size);
+    return static_cast<StyleId>(m_styles.size() - 1);
+}
+
+void
+plugin::clear()
+{
+    m_styles.clear();
+    m_margin = { 0, 0 };
+    m_queued.clear();
+
+    std::lock_guard lock(m_mutex);
+    m_published.clear();
+    m_published_clear = true;
+}
+
+Emitter&
+plugin::attach(entt::registry& ecs, entt::entity e, const EmitterDesc& desc,
+    glm::vec2 offset)
+{
+    uint32_t id;
+    if (m_free.empty()) {
+        id = m_emitters.size();
+        m_emitters.emplace_back();
+    } else {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+    m_emitters[id] = { desc };
+    return ecs.emplace<Emitter>(e, Emitter{ id, offset });
+}
+
+void
+plugin::burst(const EmitterDesc& desc, glm::vec2 pos, uint32_t count)
+{
+    m_queued.push_back({ pos, count, desc });
+}
+
+void
+plugin::publish()
+{
+    std::lock_guard lock(m_mutex);
+    m_published.insert(m_published.end(), m_queued.begin(), m_queued.end());
+    m_queued.clear();
+}
+
+void
+plugin::update(float delta)
+{
+    bool clear;
+    {
+        std::lock_guard lock(m_mutex);
+        std::swap(m_spawning, m_published);
+        clear = m_published_clear;
+        m_published_clear = false;
+    }
+    if (clear) {
+        m_particles->clear();
+    }
+    for (const auto& s : m_spawning) {
+        if (s.desc.style < m_styles.size()) {
+            m_dropped +=
+                s.count - m_particles->spawn(s, m_styles[s.desc.style]);
+        }
+    }
+    m_spawning.clear();
+
+    auto& pool = m_render->pool();
+    m_particles->update(pool, delta);
+    if (!m_draw) {
+        return;
+    }
+
+    // a particle's position is the corner of its quad nearest the origin, so
+    // particles up to a style's size before the screen may still overlap it
+    auto& quads = m_render->quads();
+    glm::vec2 min = glm::vec2(quads.origin()) - m_margin;
+    glm::vec2 max = glm::vec2(quads.origin())
+        + glm::vec2(render::RESOLUTION.x, render::RESOLUTION.y);
+    m_particles->visible(pool, min, max, m_visible);
+
+    // the animation frame follows the fraction of its life a particle has
+    // lived, so particles need no per-frame animation state
+    auto frame = [this](uint32_t p) -> const render::SpriteFrames::Frame& {
+        const auto& style = m_styles[m_particles->style(p)];
+        auto offset = static_cast<render::FrameId>(
+            m_particles->age(p) * style.frames);
+        return (*m_frames)[style.frame
+            + std::min<render::FrameId>(offset, style.frames - 1)];
+    };
+    // drawn like the sprites, so the texture array toggle covers both
+    if (m_render->texture_array() && m_frames->layers().id != SG_INVALID_ID) {
+        quads.set_layers(m_frames->layers());
+        quads.draw_layers(pool, m_visible.size(), [&](size_t i) {
+            uint32_t p = m_visible[i];
+            const auto& style = m_styles[m_particles->style(p)];
+            const auto& f = frame(p);
+            return render::QuadRenderer::LayerQuad{ m_particles->pos(p),
+                style.size, f.layer, f.uv, style.z };
+        });
+        return;
+    }
+    quads.draw_sprites(pool, m_visible.size(), [&](size_t i) {
+        uint32_t p = m_visible[i];
+        const auto& style = m_styles[m_particles->style(p)];
+        const auto& f = frame(p);
+        return render::QuadRenderer::Quad{ m_particles->pos(p), style.size,
+            f.img, f.uv, style.z };
+    });
+}
+
+void
+plugin::init(entt::registry& ecs)
+{
+    log_debug("init particles plugin");
+
+    // particles are drawn with the render plugin's renderer & pool, from the
+    // frames it draws sprites from
+    m_render = &ecs.ctx().get<render::plugin>();
+    m_frames = &ecs.ctx().get<render::SpriteFrames>();
+    m_particles = std::make_unique<Storage>(Capacity);
+
+    // emit after render::update_translate, so emitters follow their entity
+    // from this tick
+    m_emit_system = ecs.create();
+    ecs.emplace<System>(m_emit_system,
+        System::Config<const Emitter, const render::Translate>{
+            .name  = "particles::emit",
+            .stage = System::Stage::draw - 5,
+            .handler =
+                [this](auto&, auto& view, float delta) {
+                    for (auto e : view) {
+                        auto [emitter, tsl] = view.get(e);
+                        auto& slot = m_emitters[emitter.id];
+                        slot.pending += slot.desc.rate * delta;
+                        auto count = static_cast<uint32_t>(slot.pending);
+                        if (count == 0) {
+                            continue;
+                        }
+                        slot.pending -= count;
+                        m_queued.push_back(
+                            { tsl.v + emitter.offset, count, slot.desc });
+                    }
+                    publish();
+                },
+        });
+    ecs.emplace<HumanDescription>(m_emit_system, "system: emit particles",
+        "queues the particles every particles::Emitter spawns this tick, and"
+        " any bursts, for the main thread");
+
+    // after render::draw_sprites, which sets the renderer's origin
+    m_update_system = ecs.create();
+    ecs.emplace<System>(m_update_system,
+        System::Config<>{
+            .name  = "particles::update",
+            .always_run = true,
+            .stage = System::Stage::draw + 1,
+            .thread = System::Thread::main_async,
+            .handler = [this](auto&, float delta) { update(delta); },
+        });
+    ecs.emplace<HumanDescription>(m_update_system, "system: update particles",
+        "spawns queued particles, moves every particle & drops expired ones,"
+        " then draws the visible particles");
+}
+
+void
+plugin::cleanup(entt::registry& ecs)
+{
+    log_debug("cleanup particles");
+    ecs.on_destroy<Emitter>().disconnect<&plugin::on_emitter_destroy>(*this);
+    ecs.destroy(m_update_system);
+    ecs.destroy(m_emit_system);
+    m_particles.reset();
+}
+
+void
+plugin::show_stats()
+{
+    ImGui::Text("particles %zu of %zu, %zu drawn, %zu dropped",
+        m_particles->size(), m_particles->capacity(), m_visible.size(),
+        m_dropped);
+    ImGui::Text("emitters %zu, %zu free; styles %zu", m_emitters.size(),
+        m_free.size(), m_styles.size());
+    ImGui::Checkbox("draw particles", &m_draw);
+}
+
+} // namespace particles
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <entt/fwd.hpp>
+#include <entt/entity/entity.hpp>
+#include "../particles.hpp"
+#include "storage.hpp"
+
+namespace render { class plugin; }
+
+namespace particles {
+
+/// particles for effects like hit sparks, dust trails & weather
+///
+/// Emitters are pooled, and attached to entities with a particles::Emitter
+/// component.  Each tick the simulation turns every emitter, and every
+/// burst(), into spawn requests, and hands them to the main thread like
+/// render::RetainedSprites hands over its writes.  The particles themselves
+/// never touch the registry: they live in a particles::Storage owned by the
+/// main thread, which updates them alongside the simulation, and draws the
+/// visible ones from the texture array through the render plugin's
+/// QuadRenderer, over the sprites.
+class plugin {
+public:
+    /// most live particles; spawns beyond it are dropped
+    static constexpr size_t Capacity = 256 * 1024;
+
+    plugin(entt::registry&);
+
+    void init(entt::registry&);
+    void cleanup(entt::registry&);
+
+    /// add a style, returning its id; only while loading a scene
+    StyleId add_style(const Style&);
+
+    /// drop every style & particle; only while loading a scene
+    void clear();
+
+    /// attach an emitter from the pool to an entity with a render::Translate,
+    /// and no particles::Emitter yet
+    Emitter& attach(entt::registry&, entt::entity, const EmitterDesc&,
+        glm::vec2 offset = { 0, 0 });
+
+    /// spawn `count` particles at once, such as sparks from a hit;
+    /// simulation side only
+    void burst(const EmitterDesc&, glm::vec2 pos, uint32_t count);
+
+    /// show particle counts in the current ImGui window
+    void show_stats();
+
+private:
+    struct Slot {
+        EmitterDesc desc;
+        float pending{ 0 };   // fraction of a particle owed from past ticks
+    };
+
+    void on_emitter_destroy(entt::registry&, entt::entity);
+    void publish();
+    void update(float delta);
+
+    entt::entity m_emit_system{ entt::null };
+    entt::entity m_update_system{ entt::null };
+
+    // loaded with the scene, read by both threads
+    std::vector<Style> m_styles{};
+    glm::vec2 m_margin{ 0 };    // largest style size, for culling
+
+    // simulation side
+    std::vector<Slot> m_emitters{};
+    std::vector<uint32_t> m_free{};
+    std::vector<Spawn> m_queued{};
+
+    // handed from the simulation side to the main thread
+    std::mutex m_mutex;
+    std::vector<Spawn> m_published{};
+    bool m_published_clear{ false };
+
+    // main thread
+    std::vector<Spawn> m_spawning{};
+    std::unique_ptr<Storage> m_particles{ nullptr };
+    std::vector<uint32_t> m_visible{};
+    render::plugin* m_render{ nullptr };
+    const render::SpriteFrames* m_frames{ nullptr };
+    size_t m_dropped{ 0 };      // spawned particles that didn't fit
+    bool m_draw{ true };
+};
+
+} // namespace particles
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "../thread_pool.hpp"
+#include "storage.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace particles {
+
+/// semi-implicit Euler step of `count` particles, four at a time with SSE2
+/// where available; the scalar loop finishes the remainder
+static void
+integrate(float* x, float* y, float* vx, float* vy, const float* ax,
+    const float* ay, float* age, size_t count, float dt)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 t = _mm_set1_ps(dt);
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx4 = _mm_add_ps(_mm_loadu_ps(vx + i),
+            _mm_mul_ps(_mm_loadu_ps(ax + i), t));
+        __m128 vy4 = _mm_add_ps(_mm_loadu_ps(vy + i),
+            _mm_mul_ps(_mm_loadu_ps(ay + i), t));
+        _mm_storeu_ps(vx + i, vx4);
+        _mm_storeu_ps(vy + i, vy4);
+        _mm_storeu_ps(x + i,
+            _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(vx4, t)));
+        _mm_storeu_ps(y + i,
+            _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(vy4, t)));
+        _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), t));
+    }
+#endif
+    for (; i < count; i++) {
+        vx[i] += ax[i] * dt;
+        vy[i] += ay[i] * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+}
+
+Storage::Storage(size_t capacity)
+    : m_x(capacity), m_y(capacity)
+    , m_vx(capacity), m_vy(capacity)
+    , m_ax(capacity), m_ay(capacity)
+    , m_age(capacity), m_life(capacity)
+    , m_style(capacity)
+{}
+
+size_t
+Storage::spawn(const Spawn& s, const Style& style)
+{
+    if (s.desc.lifetime <= 0) {
+        return 0;
+    }
+    size_t count = std::min<size_t>(s.count, capacity() - m_size);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (size_t n = 0; n < count; n++) {
+        size_t i = m_size++;
+        float angle = unit(m_rng) * 2 * std::numbers::pi_v<float>;
+        float speed = unit(m_rng) * s.desc.spread;
+        m_x[i] = s.pos.x + unit(m_rng) * s.desc.area.x;
+        m_y[i] = s.pos.y + unit(m_rng) * s.desc.area.y;
+        m_vx[i] = s.desc.velocity.x + std::cos(angle) * speed;
+        m_vy[i] = s.desc.velocity.y + std::sin(angle) * speed;
+        m_ax[i] = style.gravity.x;
+        m_ay[i] = style.gravity.y;
+        m_age[i] = 0;
+        m_life[i] = s.desc.lifetime;
+        m_style[i] = s.desc.style;
+    }
+    return count;
+}
+
+void
+Storage::update(thread_pool& pool, float dt)
+{
+    size_t chunks = (m_size + Chunk - 1) / Chunk;
+    pool.parallel_for(chunks, [&](size_t c) {
+        size_t first = c * Chunk;
+        size_t count = std::min(Chunk, m_size - first);
+        integrate(&m_x[first], &m_y[first], &m_vx[first], &m_vy[first],
+            &m_ax[first], &m_ay[first], &m_age[first], count, dt);
+    });
+
+    // a single pass over the ages, usually without a single move
+    for (size_t i = 0; i < m_size;) {
+        if (m_age[i] < m_life[i]) {
+            i++;
+            continue;
+        }
+        move(--m_size, i);
+    }
+}
+
+void
+Storage::visible(thread_pool& pool, glm::vec2 min, glm::vec2 max,
+    std::vector<uint32_t>& out)
+{
+    size_t chunks = (m_size + Chunk - 1) / Chunk;
+    if (m_chunk_visible.size() < chunks) {
+        m_chunk_visible.resize(chunks);
+    }
+    pool.parallel_for(chunks, [&](size_t c) {
+        auto& visible = m_chunk_visible[c];
+        visible.clear();
+        size_t end = std::min(m_size, (c + 1) * Chunk);
+        for (size_t i = c * Chunk; i < end; i++) {
+            if (m_x[i] >= min.x && m_x[i] < max.x && m_y[i] >= min.y
+                    && m_y[i] < max.y) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    });
+
+    out.clear();
+    for (size_t c = 0; c < chunks; c++) {
+        out.insert(out.end(), m_chunk_visible[c].begin(),
+            m_chunk_visible[c].end());
+    }
+}
+
+void
+Storage::move(size_t from, size_t to)
+{
+    m_x[to] = m_x[from];
+    m_y[to] = m_y[from];
+    m_vx[to] = m_vx[from];
+    m_vy[to] = m_vy[from];
+    m_ax[to] = m_ax[from];
+    m_ay[to] = m_ay[from];
+    m_age[to] = m_age[from];
+    m_life[to] = m_life[from];
+    m_style[to] = m_style[from];
+}
+
+} // namespace particles
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../particles.hpp"
+
+class thread_pool;
+
+namespace particles {
+
+/// particles requested by an emitter or a burst
+struct Spawn {
+    glm::vec2 pos;
+    uint32_t count;
+    EmitterDesc desc;
+};
+
+/// every live particle, stored as one array per field
+///
+/// Particles are not entities; a frame's update is one pass of a SIMD
+/// kernel over each chunk of the arrays, spread across a thread_pool, and
+/// expired particles are dropped by moving the last one into their place,
+/// so the live particles stay packed at the front.  The arrays are
+/// allocated once, for the capacity, so spawning never allocates.
+///
+/// Owned by the main thread; see particles::plugin.
+class Storage {
+public:
+    /// particles each thread updates or culls at a time
+    static constexpr size_t Chunk = 4096;
+
+    Storage(size_t capacity);
+    Storage(const Storage&) = delete;
+
+    /// add the particles of a spawn drawn with `style`; returns how many
+    /// were added, fewer than requested once full
+    size_t spawn(const Spawn&, const Style& style);
+
+    /// move every particle by `dt` seconds across the pool, then drop the
+    /// ones that outlived their lifetime
+    void update(thread_pool&, float dt);
+
+    /// find the particles with their position in [min, max), across the
+    /// pool; `out` is replaced with their indices, in order
+    void visible(thread_pool&, glm::vec2 min, glm::vec2 max,
+        std::vector<uint32_t>& out);
+
+    /// drop every particle
+    inline void clear() { m_size = 0; }
+
+    inline size_t size() const { return m_size; }
+    inline size_t capacity() const { return m_x.size(); }
+
+    inline glm::vec2 pos(size_t i) const { return { m_x[i], m_y[i] }; }
+    inline StyleId style(size_t i) const { return m_style[i]; }
+
+    /// fraction of its lifetime a particle has lived, in [0, 1)
+    inline float age(size_t i) const { return m_age[i] / m_life[i]; }
+
+private:
+    void move(size_t from, size_t to);
+
+    size_t m_size{ 0 };
+    std::vector<float> m_x, m_y;
+    std::vector<float> m_vx, m_vy;
+    std::vector<float> m_ax, m_ay;      // the style's gravity
+    std::vector<float> m_age, m_life;   // seconds
+    std::vector<StyleId> m_style;
+    std::vector<std::vector<uint32_t>> m_chunk_visible{};
+    std::minstd_rand m_rng{};
+};
+
+} // namespace particles
@@ -11,6 +11,7 @@
 #include "physics/body.hpp"
 #include "physics/collision_type.hpp"
 #include "physics/shape.hpp"
+#include "transient.hpp"
 
 namespace physics {
 
@@ -95,6 +96,12 @@ snap_to_grid(cpVect pos)
     };
 }
 
+void
+mark_moved(entt::registry& ecs, entt::entity entity)
+{
+    ecs.ctx().get<Moved>().entities.push_back(entity);
+}
+
 } // namespace physics
 
 namespace entity_editor {
@@ -123,6 +130,7 @@ draw_component<Body>(entt::registry& ecs, entt::entity e)
                 nullptr, nullptr, "%0.3f");
             if (pos.x != orig.x || pos.y != orig.y) {
                 cpBodySetPosition(obj, pos);
+                mark_moved(ecs, e);
             }
         }
 
@@ -147,6 +155,21 @@ draw_component<Body>(entt::registry& ecs, entt::entity e)
             }
         }
 
+        // Collision isn't a component, so it can't have an editor of its
+        // own; show the one from the last physics step with the body
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("Collision");
+            ImGui::TableNextColumn();
+            if (auto* col = transient<Collision>(ecs).find(e)) {
+                ImGui::Text("normal (%0.3f, %0.3f)", col->normal.x,
+                    col->normal.y);
+            } else {
+                ImGui::TextDisabled("none");
+            }
+        }
+
         ImGui::EndTable();
     }
     ImGui::PopID();
@@ -429,27 +452,4 @@ draw_component<Movable>(entt::registry& ecs, entt::entity e)
     ImGui::PopID();
 }
 
-template <>
-void
-draw_component<Collision>(entt::registry& ecs, entt::entity e)
-{
-    auto& obj = ecs.get<Collision>(e);
-    ImGui::PushID(&obj);
-    if (ImGui::BeginTable("physics::collision", 2, 0)) {
-        ImGui::TableSetupColumn(
-            "field", ImGuiTableColumnFlags_WidthFixed, 75.0);
-        ImGui::TableSetupColumn("value", ImGuiTableColumnFlags_WidthStretch);
-
-        ImGui::TableNextRow();
-        ImGui::TableNextColumn();
-        ImGui::Text("Normal");
-        ImGui::TableNextColumn();
-        ImGui::DragScalarN("##normal", ImGuiDataType_Float, &obj.normal, 2,
-            1.0f, nullptr, nullptr, "%0.3f");
-
-        ImGui::EndTable();
-    }
-    ImGui::PopID();
-}
-
 } // namespace entity_editor
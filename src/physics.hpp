@@ -1,6 +1,7 @@
 #pragma once
 #include <chipmunk/chipmunk.h>
 #include <memory>
+#include <vector>
 
 #include "entt/entity/fwd.hpp"
 #include "physics/plugin.hpp"
@@ -64,6 +65,12 @@ struct Collision {
     cpVect normal{};
 };
 
+/// entities whose Body moved since the last render sync; stored in the
+/// registry context.  May contain duplicates & destroyed entities.
+struct Moved {
+    std::vector<entt::entity> entities;
+};
+
 /// cardinal directions
 enum cardinal_direction {
     CD_Stopped = 0,
@@ -90,4 +97,7 @@ cardinal_direction reverse_cardinal_direction(cardinal_direction dir);
 /// given a vector, return the closest grid-aligned vector to that point
 cpVect snap_to_grid(cpVect);
 
+/// record that an entity moved outside of cpSpaceStep()
+void mark_moved(entt::registry&, entt::entity);
+
 } // namespace physics
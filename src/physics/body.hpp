@@ -29,6 +29,9 @@ public:
     inline cpVect pos() const { return cpBodyGetPosition(&m_body); }
     inline cpVect cog() const { return cpBodyGetCenterOfGravity(&m_body); }
     inline cpVect velocity() const { return cpBodyGetVelocity(&m_body); }
+    inline cpBodyType type() const {
+        return cpBodyGetType(const_cast<cpBody*>(&m_body));
+    }
     inline bool stopped() const {
         cpVect v = velocity();
         return cpvnear(v, {0,0}, 0.01);
@@ -1,13 +1,23 @@
+#include <algorithm>
 #include "debug_draw.hpp"
 #include "../components.hpp"
 #include "../imgui.hpp"
 #include "../render.hpp"
+#include "../render/line_layer.hpp"
 #include "../system.hpp"
 #include "body.hpp"
 #include "shape.hpp"
 
 namespace physics {
 
+/// check if a shape is attached to a static body
+static inline bool
+is_static(const cpShape* shape)
+{
+    cpBody* body = cpShapeGetBody(shape);
+    return body && cpBodyGetType(body) == CP_BODY_TYPE_STATIC;
+}
+
 void
 debug_draw::init(entt::registry& ecs)
 {
@@ -19,25 +29,138 @@ debug_draw::init(entt::registry& ecs)
             .name       = "physics::debug_draw",
             .always_run = true,
             .stage      = System::Stage::draw_debug,
+            .thread     = System::Thread::main_sync,
             .handler    = [this](auto& ecs, float) { draw(ecs); },
         });
+
+    // static bodies hardly ever move, but when they do their shapes need to
+    // be redrawn; physics::Moved is cleared before draw_debug, so check it
+    // alongside render::update_translate
+    m_moved_system = ecs.create();
+    ecs.emplace<HumanDescription>(m_moved_system,
+        "system: physics debug draw moved",
+        "rebuild the retained debug lines when a static body moves");
+    ecs.emplace<System>(m_moved_system,
+        System::Config<>{
+            .name       = "physics::debug_draw_moved",
+            .always_run = true,
+            .stage      = System::Stage::draw - 10,
+            .handler    =
+                [this](auto& ecs, float) {
+                    auto bodies = ecs.template view<const Body>();
+                    auto& moved = ecs.ctx().template get<Moved>();
+                    for (auto e : moved.entities) {
+                        if (bodies.contains(e)
+                                && bodies.template get<const Body>(e).type()
+                                    == CP_BODY_TYPE_STATIC) {
+                            m_rebuild = true;
+                            return;
+                        }
+                    }
+                },
+        });
+
+    ecs.on_construct<Box>().connect<&debug_draw::on_shape_change>(*this);
+    ecs.on_destroy<Box>().connect<&debug_draw::on_shape_change>(*this);
+    ecs.on_construct<Segment>().connect<&debug_draw::on_shape_change>(*this);
+    ecs.on_destroy<Segment>().connect<&debug_draw::on_shape_change>(*this);
 }
 
 void
 debug_draw::cleanup(entt::registry& ecs)
 {
+    ecs.on_construct<Box>().disconnect<&debug_draw::on_shape_change>(*this);
+    ecs.on_destroy<Box>().disconnect<&debug_draw::on_shape_change>(*this);
+    ecs.on_construct<Segment>().disconnect<&debug_draw::on_shape_change>(
+        *this);
+    ecs.on_destroy<Segment>().disconnect<&debug_draw::on_shape_change>(*this);
+    ecs.destroy(m_moved_system);
     ecs.destroy(m_system);
 }
 
+void
+debug_draw::on_shape_change(entt::registry&, entt::entity)
+{
+    m_rebuild = true;
+}
+
+void
+debug_draw::draw_static(entt::registry& ecs)
+{
+    auto& lines = ecs.ctx().template get<render::plugin>().debug_lines();
+    lines.clear();
+
+    if (m_draw_segment) {
+        for (auto&& [entity, segment] : ecs.view<const Segment>().each()) {
+            if (!is_static(segment)) {
+                continue;
+            }
+            cpVect a = segment.ta();
+            cpVect b = segment.tb();
+            lines.draw_seg(
+                { a.x, a.y }, { b.x, b.y }, { 0xff, 0, 0xff, 0xff });
+        }
+    }
+
+    if (m_draw_box) {
+        for (auto&& [entity, box] : ecs.view<const Box>().each()) {
+            if (!is_static(box)) {
+                continue;
+            }
+            cpVect pos  = box.top_left();
+            cpVect size = box.size();
+            lines.draw_rect(
+                { pos.x, pos.y }, { size.x, size.y }, { 0xff, 0, 0, 0xff });
+        }
+    }
+
+    if (m_draw_body) {
+        for (auto&& [entity, body] : ecs.view<const Body>().each()) {
+            if (body.type() != CP_BODY_TYPE_STATIC) {
+                continue;
+            }
+            cpVect pos = body.pos();
+            lines.draw_rect(
+                { pos.x - 1, pos.y - 1 }, { 2, 2 }, { 0xff, 0xff, 0, 0xff });
+        }
+    }
+
+    lines.bake();
+}
+
 void
 debug_draw::draw(entt::registry& ecs)
 {
     auto& render = ecs.ctx().template get<render::plugin>();
 
+    if (m_rebuild) {
+        draw_static(ecs);
+        m_rebuild = false;
+    }
+    render.show_debug_lines();
+
+    // bounds of the screen; only shapes that overlap it are drawn.  Frames
+    // are rendered from the last snapshot, which may trail the camera body,
+    // so allow some margin.
+    cpBB screen{};
+    for (auto&& [e, body] :
+            ecs.view<const render::Camera, const Body>().each()) {
+        cpVect min = body.pos() - render::RESOLUTION / 2;
+        cpVect max = body.pos() + render::RESOLUTION * 1.5;
+        screen = cpBBNew(min.x, min.y, max.x, max.y);
+    }
+    auto visible = [&screen](cpVect a, cpVect b) {
+        return cpBBIntersects(screen, cpBBNew(std::min(a.x, b.x),
+            std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y)));
+    };
+
     if (m_draw_segment) {
         for (auto&& [entity, segment] : ecs.view<const Segment>().each()) {
             cpVect a = segment.ta();
             cpVect b = segment.tb();
+            if (is_static(segment) || !visible(a, b)) {
+                continue;
+            }
 
             render.draw_line(
                 { a.x, a.y }, { b.x, b.y }, { 0xff, 0, 0xff, 0xff });
@@ -48,6 +171,9 @@ debug_draw::draw(entt::registry& ecs)
         for (auto&& [entity, box] : ecs.view<const Box>().each()) {
             cpVect pos  = box.top_left();
             cpVect size = box.size();
+            if (is_static(box) || !visible(pos, pos + size)) {
+                continue;
+            }
 
             render.draw_rect(
                 { pos.x, pos.y }, { size.x, size.y }, { 0xff, 0, 0, 0xff });
@@ -57,6 +183,9 @@ debug_draw::draw(entt::registry& ecs)
     if (m_draw_body) {
         for (auto&& [entity, body] : ecs.view<const Body>().each()) {
             cpVect pos = body.pos();
+            if (body.type() == CP_BODY_TYPE_STATIC || !visible(pos, pos)) {
+                continue;
+            }
             render.draw_rect(
                 { pos.x - 1, pos.y - 1 }, { 2, 2 }, { 0xff, 0xff, 0, 0xff });
         }
@@ -67,6 +196,9 @@ debug_draw::draw(entt::registry& ecs)
                 ecs.view<const Body, const Destination>().each()) {
             cpVect a = body.pos();
             cpVect b = dest.pos;
+            if (!visible(a, b)) {
+                continue;
+            }
 
             render.draw_line(
                 { a.x, a.y }, { b.x, b.y }, { 0xff, 0xff, 0, 0xff });
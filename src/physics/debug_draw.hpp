@@ -4,6 +4,12 @@
 
 namespace physics {
 
+/// debug drawing of physics shapes
+///
+/// Shapes on static bodies are drawn into the render plugin's retained
+/// debug_lines() layer, which is only rebuilt when a shape is added or
+/// removed, or a static body moves.  Everything else is drawn every frame,
+/// but only when it overlaps the camera.
 class debug_draw {
 public:
     debug_draw(entt::registry&) {};
@@ -12,11 +18,16 @@ public:
     void draw(entt::registry&);
 
 private:
+    void on_shape_change(entt::registry&, entt::entity);
+    void draw_static(entt::registry&);
+
     entt::entity m_system;
+    entt::entity m_moved_system;
     bool m_draw_body{true};
     bool m_draw_dest{true};
     bool m_draw_box{true};
     bool m_draw_segment{true};
+    bool m_rebuild{true};   // set when the static shapes need to be redrawn
 };
 
 } // namespace render
@@ -9,27 +9,53 @@
 #include "../imgui.hpp"
 #include "../log.hpp"
 #include "../physics.hpp"
+#include "../render.hpp"
 #include "../system.hpp"
 #include "../tags.hpp"
+#include "../transient.hpp"
 #include "body.hpp"
 #include "chipmunk/chipmunk_unsafe.h"
 #include "chipmunk/cpVect.h"
 #include "collision_type.hpp"
+#include "../thread_pool.hpp"
 #include "plugin.hpp"
+#include "rooms.hpp"
 #include "shape.hpp"
 #include "space.hpp"
 
 namespace physics {
 
+/// position update function for all bodies; records the bodies that actually
+/// moved during cpSpaceStep() so the render sync only touches those.
+static void
+update_body_position(cpBody* body, cpFloat dt)
+{
+    cpVect before = cpBodyGetPosition(body);
+    cpBodyUpdatePosition(body, dt);
+    if (cpveql(before, cpBodyGetPosition(body))) {
+        return;
+    }
+
+    // called from the thread stepping the room; the room's list is merged
+    // into physics::Moved after the step
+    auto entity = (entt::entity)(uintptr_t)cpBodyGetUserData(body);
+    Rooms::room_of(body).moved.push_back(entity);
+}
+
 static void
 on_body_construct(entt::registry& ecs, entt::entity e)
 {
     auto& body = ecs.get<Body>(e);
     log_trace("construct entity {}, Body {}", e, fmt::ptr(&body));
-    auto& space = ecs.ctx().get<Space>();
+    auto& room = ecs.ctx().get<Rooms>().room(body.pos());
 
     cpBodySetUserData(body, (void*)e);
-    cpSpaceAddBody(space, body);
+    cpBodySetPositionUpdateFunc(body, update_body_position);
+    cpSpaceAddBody(room.space, body);
+
+    // new bodies need at least one sync, and a migration to the right room
+    // once their position has been set
+    mark_moved(ecs, e);
 }
 
 static void
@@ -38,8 +64,8 @@ on_body_destroy(entt::registry& ecs, entt::entity e)
     auto& body = ecs.get<Body>(e);
     log_trace("destroy entity {}, Body {}", e, fmt::ptr(&body));
 
-    auto& space = ecs.ctx().get<Space>();
-    cpSpaceRemoveBody(space, body);
+    ecs.ctx().get<Rooms>().remove_ghosts(body);
+    cpSpaceRemoveBody(cpBodyGetSpace(body), body);
 }
 
 template <typename Type>
@@ -51,9 +77,11 @@ on_shape_construct(entt::registry& r, entt::entity e)
 
     auto& body = r.get<Body>(shape.parent);
     cpShapeSetBody(shape, body);
+    cpSpaceAddShape(cpBodyGetSpace(body), shape);
 
-    auto& space = r.ctx().get<Space>();
-    cpSpaceAddShape(space, shape);
+    // the body's ghosts are rebuilt with the shape when it's next migrated
+    r.ctx().get<Rooms>().remove_ghosts(body);
+    mark_moved(r, shape.parent);
 }
 
 template <typename Type>
@@ -65,12 +93,21 @@ on_shape_destroy(entt::registry& r, entt::entity e)
 
     cpSpace* space = cpShapeGetSpace(shape);
     cpSpaceRemoveShape(space, shape);
+
+    // likewise rebuilt without it, unless the body went first
+    if (auto* body = r.try_get<Body>(shape.parent)) {
+        r.ctx().get<Rooms>().remove_ghosts(*body);
+        mark_moved(r, shape.parent);
+    }
 }
 
 plugin::plugin(entt::registry& ecs)
 {
     log_debug("load physics plugin");
 
+    ecs.ctx().emplace<Moved>();
+    ecs.ctx().emplace<Rooms>(ecs);
+
     ecs.on_construct<Body>().connect<on_body_construct>();
     ecs.on_destroy<Body>().connect<on_body_destroy>();
 
@@ -93,73 +130,69 @@ plugin::init(entt::registry& ecs)
         editor.add<Movable>("physics::Movable");
         editor.add<Destination>("physics::Destination");
         editor.add<Accelerate>("physics::Accelerate");
-        editor.add<Collision>("physics::Collision");
     }
 
-    // set up physics space
-    auto& space = ecs.ctx().emplace<Space>();
-    cpSpaceSetGravity(space, { 0, 0 });
-    cpSpaceSetUserData(space, &ecs);
-    cpCollisionHandler* handler =
-        cpSpaceAddWildcardHandler(space, physics::CT_Player);
-    handler->userData  = &ecs;
-    handler->beginFunc = [](cpArbiter* arb, cpSpace*,
-                             cpDataPointer data) -> cpBool {
-        auto* ecs = static_cast<entt::registry*>(data);
-        assert(ecs != nullptr && "invalid ecs registry in space userdata");
-
-        cpBody *a, *b;
-        cpArbiterGetBodies(arb, &a, &b);
-        // log_debug("collision player ({}), other ({})", *a, *b);
-
-        entt::entity player = (entt::entity)(uintptr_t)cpBodyGetUserData(a);
-        entt::entity other  = (entt::entity)(uintptr_t)cpBodyGetUserData(b);
-
-        log_debug("collision: norm {}, depth {}, a {}, b {}",
-            cpArbiterGetNormal(arb), cpArbiterGetDepth(arb, 1), player, other);
-
-        cpVect normal = cpArbiterGetNormal(arb);
-        ecs->emplace_or_replace<Collision>(other, normal);
-        ecs->emplace_or_replace<Collision>(player, normal);
-
-        return false;
-    };
+    // collisions only live until the next physics step
+    ecs.ctx().emplace<Transient<Collision>>();
 
     entt::entity entity = ecs.create();
     ecs.emplace<System>(entity,
-        System::Config<Collision>{
+        System::Config<>{
             .name  = "physics::clear_collisions",
             .stage = System::Stage::update - 1,
+            .handler =
+                [](auto& ecs, float) { transient<Collision>(ecs).clear(); },
+        });
+    ecs.emplace<HumanDescription>(entity, "System: ClearCollisions",
+        "clear collision component from all entities before physics update");
+
+    entity = ecs.create();
+    ecs.emplace<System>(entity,
+        System::Config<const render::Camera, const Body>{
+            .name  = "physics::update_lod",
+            .stage = System::Stage::update - 2,
             .handler =
                 [](auto& ecs, auto& view, float) {
-                    for (auto entity : view) {
-                        ecs.template remove<Collision>(entity);
+                    auto& rooms = ecs.ctx().template get<Rooms>();
+                    for (auto&& [entity, body] : view.each()) {
+                        rooms.update_lod(Rooms::key(body.pos()));
+                        break;
                     }
                 },
         });
-    ecs.emplace<HumanDescription>(entity, "System: ClearCollisions",
-        "clear collision component from all entities before physics update");
+    ecs.emplace<HumanDescription>(entity, "system: physics::update_lod",
+        "step rooms near the camera every tick, distant rooms at a reduced"
+        " rate, and freeze the rest");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
         System::Config<>{
             .name    = "physics::step_space",
             .stage   = System::Stage::update,
-            .handler = [&space](
-                           auto&, float delta) { cpSpaceStep(space, delta); },
+            .handler =
+                [](auto& ecs, float delta) {
+                    auto& pool = ecs.ctx().template get<thread_pool>();
+                    ecs.ctx().template get<Rooms>().step(pool, delta);
+                },
         });
     ecs.emplace<HumanDescription>(entity, "system: update physics",
-        "Step the physics space to update all physics bodies");
+        "Step the physics space of every room, in parallel, to update all"
+        " physics bodies");
     m_system_step = entity;
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
-        System::Config<const Collision, Destination, Body>{
+        System::Config<>{
             .name  = "physics::collision_on_destination",
             .stage = System::Stage::update + 1,
             .handler =
-                [](auto& ecs, auto& view, float) {
-                    for (auto&& [entity, col, dest, body] : view.each()) {
+                [](auto& ecs, float) {
+                    auto view = ecs.template view<Destination, Body>();
+                    for (auto& [entity, col] : transient<Collision>(ecs)) {
+                        if (!view.contains(entity)) {
+                            continue;
+                        }
+                        auto [dest, body] = view.get(entity);
                         body.stop();
                         dest.pos = snap_to_grid(body.pos());
                         ecs.template emplace_or_replace<Accelerate>(entity,
@@ -214,7 +247,11 @@ plugin::init(entt::registry& ecs)
             .stage = System::Stage::update - 1,
             .handler =
                 [](auto& ecs, auto& view, float) {
+                    auto dormant = ecs.template view<tags::Dormant>();
                     for (auto&& [entity, accel, body] : view.each()) {
+                        if (dormant.contains(entity)) {
+                            continue;
+                        }
                         cpVect vel = body.velocity();
                         if (cpvlength(vel) >= accel.cap) {
                             cpBodySetVelocity(body, cpvclamp(vel, accel.cap));
@@ -235,7 +272,11 @@ plugin::init(entt::registry& ecs)
             .stage = System::Stage::update + 1,
             .handler =
                 [](auto& ecs, auto& view, float) {
+                    auto dormant = ecs.template view<tags::Dormant>();
                     for (auto&& [entity, dest, body] : view.each()) {
+                        if (dormant.contains(entity)) {
+                            continue;
+                        }
                         // log_debug("dest_system: e {}, body {}, dest {}",
                         //     entity, body, dest.pos);
 
@@ -268,6 +309,7 @@ plugin::init(entt::registry& ecs)
                         // body at destination, let's halt at the right cords
                         cpBodySetVelocity(body, { 0, 0 });
                         cpBodySetPosition(body, dest.pos);
+                        mark_moved(ecs, entity);
                         ecs.template remove<Destination>(entity);
                         if (ecs.template all_of<Accelerate>(entity)) {
                             ecs.template remove<Accelerate>(entity);
@@ -278,6 +320,43 @@ plugin::init(entt::registry& ecs)
     ecs.emplace<HumanDescription>(entity, "system: physics::destination",
         "stop physics bodies when they reach their destination");
 
+    entity = ecs.create();
+    ecs.emplace<System>(entity,
+        System::Config<>{
+            .name  = "physics::migrate_bodies",
+            .stage = System::Stage::update + 2,
+            .handler =
+                [](auto& ecs, float) {
+                    auto& rooms = ecs.ctx().template get<Rooms>();
+                    auto bodies = ecs.template view<Body>();
+                    auto& moved = ecs.ctx().template get<Moved>();
+                    for (auto e : moved.entities) {
+                        if (!bodies.contains(e)) {
+                            continue;
+                        }
+                        auto& body = bodies.template get<Body>(e);
+                        rooms.migrate(body, rooms.room(body.pos()));
+                        rooms.update_ghosts(body);
+                    }
+                },
+        });
+    ecs.emplace<HumanDescription>(entity, "system: physics::migrate_bodies",
+        "move bodies that crossed a room boundary into the space of their"
+        " new room, and their ghosts into the rooms their shapes reach");
+
+    entity = ecs.create();
+    ecs.emplace<System>(entity,
+        System::Config<>{
+            .name  = "physics::clear_moved",
+            .stage = System::Stage::draw + 1,
+            .handler =
+                [](auto& ecs, float) {
+                    ecs.ctx().template get<Moved>().entities.clear();
+                },
+        });
+    ecs.emplace<HumanDescription>(entity, "system: physics::clear_moved",
+        "clear the list of moved bodies once the draw stage has consumed it");
+
 }
 
 } // namespace physics
@@ -0,0 +1,479 @@
+#include <chipmunk/chipmunk.h>
+#include <algorithm>
+#include <cmath>
+#include <entt/entt.hpp>
+
+#include "../fmt/chipmunk.hpp"
+#include "../fmt/entt.hpp"
+#include "../log.hpp"
+#include "../physics.hpp"
+#include "../render.hpp"
+#include "../tags.hpp"
+#include "../thread_pool.hpp"
+#include "../transient.hpp"
+#include "collision_type.hpp"
+#include "rooms.hpp"
+
+namespace physics {
+
+const std::array<const char*, RL_Max> room_lod_name = {
+    "Full",
+    "Reduced",
+    "Frozen",
+};
+
+// sleeping requires a finite sleep time threshold; make it large enough that
+// chipmunk never puts bodies to sleep on its own.
+static constexpr cpFloat SLEEP_THRESHOLD = 1e6;
+
+Rooms::~Rooms()
+{
+    for (auto& [body, ghosts] : m_ghosts) {
+        for (auto& ghost : ghosts) {
+            destroy(ghost);
+        }
+    }
+}
+
+Rooms::Key
+Rooms::key(cpVect pos)
+{
+    return key(
+        static_cast<int32_t>(std::floor(pos.x / render::RESOLUTION.x)),
+        static_cast<int32_t>(std::floor(pos.y / render::RESOLUTION.y)));
+}
+
+Rooms::Key
+Rooms::key(int32_t x, int32_t y)
+{
+    return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32
+        | static_cast<uint32_t>(y);
+}
+
+std::pair<int32_t, int32_t>
+Rooms::coords(Key key)
+{
+    return {
+        static_cast<int32_t>(static_cast<uint32_t>(key >> 32)),
+        static_cast<int32_t>(static_cast<uint32_t>(key)),
+    };
+}
+
+cpVect
+Rooms::origin(Key key)
+{
+    auto [x, y] = coords(key);
+    return { x * render::RESOLUTION.x, y * render::RESOLUTION.y };
+}
+
+Rooms::Room&
+Rooms::room_of(const cpBody* body)
+{
+    auto* room = static_cast<Room*>(cpSpaceGetUserData(cpBodyGetSpace(body)));
+    assert(room != nullptr && "body has not been added to a room");
+    return *room;
+}
+
+Rooms::Room&
+Rooms::room(Key key)
+{
+    auto& room = m_rooms[key];
+    if (room) {
+        return *room;
+    }
+
+    room = std::make_unique<Room>();
+    room->key = key;
+    log_debug("create room {}", origin(key));
+
+    cpSpace* space = room->space;
+    cpSpaceSetGravity(space, { 0, 0 });
+    cpSpaceSetSleepTimeThreshold(space, SLEEP_THRESHOLD);
+    cpSpaceSetUserData(space, room.get());
+
+    // collisions are recorded in the room, and only applied to the registry
+    // after all rooms have been stepped.
+    cpCollisionHandler* handler =
+        cpSpaceAddWildcardHandler(space, physics::CT_Player);
+    handler->userData  = room.get();
+    handler->beginFunc = [](cpArbiter* arb, cpSpace*,
+                             cpDataPointer data) -> cpBool {
+        auto* room = static_cast<Room*>(data);
+
+        cpBody *a, *b;
+        cpArbiterGetBodies(arb, &a, &b);
+
+        entt::entity player = (entt::entity)(uintptr_t)cpBodyGetUserData(a);
+        entt::entity other  = (entt::entity)(uintptr_t)cpBodyGetUserData(b);
+
+        log_debug("collision: norm {}, depth {}, a {}, b {}",
+            cpArbiterGetNormal(arb), cpArbiterGetDepth(arb, 1), player, other);
+
+        cpVect normal = cpArbiterGetNormal(arb);
+        room->collisions.emplace_back(other, normal);
+        room->collisions.emplace_back(player, normal);
+
+        return false;
+    };
+
+    return *room;
+}
+
+static void
+collect_shape(cpBody*, cpShape* shape, void* data)
+{
+    static_cast<std::vector<cpShape*>*>(data)->push_back(shape);
+}
+
+static void
+collect_body(cpBody* body, void* data)
+{
+    static_cast<std::vector<cpBody*>*>(data)->push_back(body);
+}
+
+static entt::entity
+body_entity(const cpBody* body)
+{
+    return (entt::entity)(uintptr_t)cpBodyGetUserData(body);
+}
+
+/// velocity update function for ghosts, which also tells them apart from
+/// bodies; their velocity is copied from their body before every step, so
+/// forces are never integrated
+static void
+ghost_velocity(cpBody*, cpVect, cpFloat, cpFloat)
+{}
+
+static bool
+is_ghost(const cpBody* body)
+{
+    return body->velocity_func == ghost_velocity;
+}
+
+/// copy a shape onto a ghost body, with the same geometry relative to the
+/// body, and the same collision properties
+static cpShape*
+copy_shape(cpBody* body, const cpShape* shape)
+{
+    cpShape* copy;
+    switch (shape->klass->type) {
+    case CP_CIRCLE_SHAPE:
+        copy = cpCircleShapeNew(body, cpCircleShapeGetRadius(shape),
+            cpCircleShapeGetOffset(shape));
+        break;
+    case CP_SEGMENT_SHAPE:
+        copy = cpSegmentShapeNew(body, cpSegmentShapeGetA(shape),
+            cpSegmentShapeGetB(shape), cpSegmentShapeGetRadius(shape));
+        break;
+    case CP_POLY_SHAPE: {
+        // the vertices are already a hull, in body coordinates
+        std::vector<cpVect> verts(cpPolyShapeGetCount(shape));
+        for (size_t i = 0; i < verts.size(); i++) {
+            verts[i] = cpPolyShapeGetVert(shape, static_cast<int>(i));
+        }
+        copy = cpPolyShapeNewRaw(body, static_cast<int>(verts.size()),
+            verts.data(), cpPolyShapeGetRadius(shape));
+        break;
+    }
+    default:
+        return nullptr;
+    }
+
+    cpShapeSetSensor(copy, cpShapeGetSensor(shape));
+    cpShapeSetCollisionType(copy, cpShapeGetCollisionType(shape));
+    cpShapeSetFilter(copy, cpShapeGetFilter(shape));
+    cpShapeSetElasticity(copy, cpShapeGetElasticity(shape));
+    cpShapeSetFriction(copy, cpShapeGetFriction(shape));
+    return copy;
+}
+
+void
+Rooms::migrate(cpBody* body, Room& to)
+{
+    cpSpace* from = cpBodyGetSpace(body);
+    cpSpace* dest = to.space;
+    if (from == dest) {
+        // moved within a frozen room (editor); setting the position woke it
+        if (to.lod == RL_Frozen && !cpBodyIsSleeping(body)) {
+            sleep(body);
+        }
+        return;
+    }
+    log_trace("migrate body {} to room {}", fmt::ptr(body), origin(to.key));
+
+    std::vector<cpShape*> shapes;
+    cpBodyEachShape(body, collect_shape, &shapes);
+
+    for (cpShape* shape : shapes) {
+        cpSpaceRemoveShape(from, shape);
+    }
+    cpSpaceRemoveBody(from, body);
+    cpSpaceAddBody(dest, body);
+    for (cpShape* shape : shapes) {
+        cpSpaceAddShape(dest, shape);
+    }
+
+    // take on the state of the new room
+    if (to.lod == RL_Frozen) {
+        sleep(body);
+    } else {
+        wake(body);
+    }
+}
+
+Rooms::Ghost
+Rooms::ghost(cpBody* body, Room& room)
+{
+    cpBody* copy;
+    switch (cpBodyGetType(body)) {
+    case CP_BODY_TYPE_STATIC: copy = cpBodyNewStatic(); break;
+    case CP_BODY_TYPE_KINEMATIC: copy = cpBodyNewKinematic(); break;
+    default:
+        copy = cpBodyNew(cpBodyGetMass(body), cpBodyGetMoment(body));
+        break;
+    }
+    cpBodySetUserData(copy, cpBodyGetUserData(body));
+    cpBodySetVelocityUpdateFunc(copy, ghost_velocity);
+    cpSpaceAddBody(room.space, copy);
+
+    // in place before the shapes are added, so static ones are indexed there
+    Ghost ghost{ &room, copy };
+    sync(body, ghost);
+
+    std::vector<cpShape*> shapes;
+    cpBodyEachShape(body, collect_shape, &shapes);
+    for (cpShape* shape : shapes) {
+        if (cpShape* s = copy_shape(copy, shape)) {
+            cpSpaceAddShape(room.space, s);
+            ghost.shapes.push_back(s);
+        }
+    }
+    return ghost;
+}
+
+void
+Rooms::sync(cpBody* body, Ghost& ghost)
+{
+    cpBodySetPosition(ghost.body, cpBodyGetPosition(body));
+    cpBodySetAngle(ghost.body, cpBodyGetAngle(body));
+    if (cpBodyGetType(ghost.body) == CP_BODY_TYPE_STATIC) {
+        cpSpaceReindexShapesForBody(ghost.room->space, ghost.body);
+        return;
+    }
+    cpBodySetVelocity(ghost.body,
+        cpBodyIsSleeping(body) ? cpvzero : cpBodyGetVelocity(body));
+}
+
+void
+Rooms::destroy(Ghost& ghost)
+{
+    for (cpShape* shape : ghost.shapes) {
+        cpSpaceRemoveShape(ghost.room->space, shape);
+        cpShapeFree(shape);
+    }
+    cpSpaceRemoveBody(ghost.room->space, ghost.body);
+    cpBodyFree(ghost.body);
+}
+
+void
+Rooms::update_ghosts(cpBody* body)
+{
+    std::vector<cpShape*> shapes;
+    cpBodyEachShape(body, collect_shape, &shapes);
+    if (shapes.empty()) {
+        remove_ghosts(body);
+        return;
+    }
+
+    // the rooms overlapped by the shapes where the body is now; the cached
+    // bounds are from the last step, or wherever the shape was added
+    cpBB bb = cpShapeCacheBB(shapes[0]);
+    for (size_t i = 1; i < shapes.size(); i++) {
+        bb = cpBBMerge(bb, cpShapeCacheBB(shapes[i]));
+    }
+    auto [x0, y0] = coords(key(cpv(bb.l, bb.b)));
+    auto [x1, y1] = coords(key(cpv(bb.r, bb.t)));
+    Room& home = room_of(body);
+
+    // drop the ghosts in rooms the shapes left, or that the body moved into
+    auto& ghosts = m_ghosts[body];
+    for (size_t i = 0; i < ghosts.size();) {
+        auto [x, y] = coords(ghosts[i].room->key);
+        if (ghosts[i].room != &home && x >= x0 && x <= x1 && y >= y0
+                && y <= y1) {
+            i++;
+            continue;
+        }
+        destroy(ghosts[i]);
+        ghosts[i] = ghosts.back();
+        ghosts.pop_back();
+    }
+
+    for (int32_t y = y0; y <= y1; y++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            Key k = key(x, y);
+            if (k == home.key
+                || std::any_of(ghosts.begin(), ghosts.end(),
+                    [k](const Ghost& g) { return g.room->key == k; })) {
+                continue;
+            }
+            log_trace("add ghost of body {} to room {}", fmt::ptr(body),
+                origin(k));
+            ghosts.push_back(ghost(body, room(k)));
+        }
+    }
+
+    if (ghosts.empty()) {
+        m_ghosts.erase(body);
+        return;
+    }
+    for (auto& g : ghosts) {
+        sync(body, g);
+    }
+}
+
+void
+Rooms::remove_ghosts(cpBody* body)
+{
+    auto it = m_ghosts.find(body);
+    if (it == m_ghosts.end()) {
+        return;
+    }
+    for (auto& ghost : it->second) {
+        destroy(ghost);
+    }
+    m_ghosts.erase(it);
+}
+
+void
+Rooms::sleep(cpBody* body)
+{
+    m_ecs.emplace_or_replace<tags::Dormant>(body_entity(body));
+    if (cpBodyGetType(body) == CP_BODY_TYPE_DYNAMIC
+        && !cpBodyIsSleeping(body)) {
+        cpBodySleep(body);
+    }
+}
+
+void
+Rooms::wake(cpBody* body)
+{
+    m_ecs.remove<tags::Dormant>(body_entity(body));
+    if (cpBodyIsSleeping(body)) {
+        cpBodyActivate(body);
+    }
+}
+
+void
+Rooms::set_lod(Room& room, room_lod lod)
+{
+    if (room.lod == lod) {
+        return;
+    }
+    log_debug("room {}: {} -> {}", origin(room.key), room_lod_name[room.lod],
+        room_lod_name[lod]);
+
+    bool freeze = lod == RL_Frozen;
+    bool thaw = room.lod == RL_Frozen;
+    room.lod = lod;
+    room.ticks = 0;
+    room.delta = 0;
+
+    if (!freeze && !thaw) {
+        return;
+    }
+
+    // chipmunk locks the space while iterating, so collect the bodies first
+    std::vector<cpBody*> bodies;
+    cpSpaceEachBody(room.space, collect_body, &bodies);
+    for (cpBody* body : bodies) {
+        // a ghost's entity belongs to the room of its body
+        if (is_ghost(body)) {
+            continue;
+        }
+        if (freeze) {
+            sleep(body);
+        } else {
+            wake(body);
+        }
+    }
+}
+
+void
+Rooms::update_lod(Key camera)
+{
+    auto [cx, cy] = coords(camera);
+    for (auto& [key, room] : m_rooms) {
+        auto [x, y] = coords(key);
+        int64_t dist = std::max(std::abs(int64_t{ x } - cx),
+                                std::abs(int64_t{ y } - cy));
+
+        if (dist <= ROOM_FULL_RANGE) {
+            set_lod(*room, RL_Full);
+        } else if (dist <= ROOM_REDUCED_RANGE) {
+            set_lod(*room, RL_Reduced);
+        } else {
+            set_lod(*room, RL_Frozen);
+        }
+    }
+}
+
+void
+Rooms::step(thread_pool& pool, float delta)
+{
+    m_step.clear();
+    for (auto& [key, room] : m_rooms) {
+        if (room->lod == RL_Frozen) {
+            continue;
+        }
+
+        room->delta += delta;
+        room->ticks++;
+        if (room->lod == RL_Reduced && room->ticks < ROOM_REDUCED_INTERVAL) {
+            continue;
+        }
+        m_step.push_back(room.get());
+    }
+
+    // ghosts of moving bodies follow them through the step at their velocity
+    for (auto& [body, ghosts] : m_ghosts) {
+        if (cpBodyGetType(body) == CP_BODY_TYPE_STATIC) {
+            continue;
+        }
+        for (auto& ghost : ghosts) {
+            sync(body, ghost);
+        }
+    }
+
+    pool.parallel_for(m_step.size(), [this](size_t i) {
+        Room* room = m_step[i];
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // chipmunk tunnels & destabilizes constraints with large steps, so
+        // the time accumulated by reduced rooms is stepped in pieces of at
+        // most ROOM_MAX_STEP, and time lost to long hitches is dropped
+        float delta = std::min(room->delta,
+            ROOM_MAX_STEP * ROOM_REDUCED_INTERVAL);
+        unsigned steps = std::max(1u,
+            static_cast<unsigned>(std::ceil(delta / ROOM_MAX_STEP - 1e-3f)));
+        for (unsigned n = 0; n < steps; n++) {
+            cpSpaceStep(room->space, delta / steps);
+        }
+        room->perf = std::chrono::high_resolution_clock::now() - start;
+        room->delta = 0;
+        room->ticks = 0;
+    });
+
+    auto& moved = m_ecs.ctx().get<Moved>().entities;
+    auto& collisions = transient<Collision>(m_ecs);
+    for (Room* room : m_step) {
+        moved.insert(moved.end(), room->moved.begin(), room->moved.end());
+        for (auto& [entity, normal] : room->collisions) {
+            collisions.emplace_or_replace(entity, normal);
+        }
+        room->moved.clear();
+        room->collisions.clear();
+    }
+}
+
+} // namespace physics
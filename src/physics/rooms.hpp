@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <chipmunk/chipmunk.h>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <entt/fwd.hpp>
+
+#include "space.hpp"
+
+class thread_pool;
+
+namespace physics {
+
+/// simulation level of detail for a room, based on distance from the camera
+enum room_lod {
+    RL_Full = 0,    // stepped every tick
+    RL_Reduced,     // stepped every ROOM_REDUCED_INTERVAL ticks
+    RL_Frozen,      // not stepped; bodies asleep & tagged tags::Dormant
+    RL_Max,
+};
+
+extern const std::array<const char *, RL_Max> room_lod_name;
+
+/// rooms within this many rooms of the camera's room run at full rate
+constexpr int ROOM_FULL_RANGE = 1;
+/// rooms within this many rooms of the camera's room run at a reduced rate
+constexpr int ROOM_REDUCED_RANGE = 3;
+/// number of ticks between steps for rooms running at a reduced rate
+constexpr unsigned ROOM_REDUCED_INTERVAL = 4;
+/// longest single cpSpaceStep(); longer deltas are split into substeps
+constexpr float ROOM_MAX_STEP = 1.0f / 30;
+
+/// physics spaces partitioned into screen-sized rooms
+///
+/// Each room has its own cpSpace, so rooms can be stepped independently, and
+/// in parallel, with each broadphase only holding the bodies of one room.
+/// Bodies are assigned to the room containing their position, and are
+/// migrated by the physics::migrate_bodies system when they cross into
+/// another room.  A body whose shapes reach into neighbouring rooms also
+/// gets a ghost in each of them: a copy of the body & its shapes, with the
+/// same entity, that follows the body.  Contacts with a ghost are recorded
+/// for the body's entity, so bodies straddling a room edge still collide
+/// with bodies on the other side.
+///
+/// Rooms away from the camera are simulated at a lower level of detail; see
+/// room_lod.
+///
+/// Stored in the registry context.
+class Rooms {
+public:
+    using Key = uint64_t;
+
+    struct Room {
+        Key key;
+        Space space{};
+        room_lod lod{ RL_Full };
+        unsigned ticks{ 0 };    // ticks since the last step
+        float delta{ 0 };       // time accumulated since the last step
+        std::chrono::nanoseconds perf{ 0 }; // duration of the last step
+
+        /// events recorded by chipmunk callbacks during cpSpaceStep(); they
+        /// are applied to the registry once all rooms have been stepped.
+        std::vector<entt::entity> moved{};
+        std::vector<std::pair<entt::entity, cpVect>> collisions{};
+    };
+
+    Rooms(entt::registry& ecs) : m_ecs{ ecs } {};
+    Rooms(const Rooms&) = delete;
+    ~Rooms();
+
+    /// get the key for the room containing a position
+    static Key key(cpVect pos);
+
+    /// get the top-left corner of a room
+    static cpVect origin(Key);
+
+    /// get the room a body has been added to
+    static Room& room_of(const cpBody*);
+
+    /// get the room for a key, creating it if needed
+    Room& room(Key);
+
+    /// get the room containing a position, creating it if needed
+    inline Room& room(cpVect pos) { return room(key(pos)); }
+
+    /// move a body, along with all of its shapes, into another room
+    void migrate(cpBody*, Room&);
+
+    /// add a ghost of a body to every other room its shapes overlap, drop
+    /// the ghosts in rooms they no longer overlap, and move the rest to the
+    /// body; call after migrate()
+    void update_ghosts(cpBody*);
+
+    /// remove every ghost of a body; call when it's destroyed, or its shapes
+    /// change
+    void remove_ghosts(cpBody*);
+
+    /// update the level of detail of every room for the camera's room
+    void update_lod(Key camera);
+
+    /// step every room that is due, and apply the recorded events to the
+    /// registry
+    void step(thread_pool&, float delta);
+
+    inline auto begin() { return m_rooms.begin(); }
+    inline auto end() { return m_rooms.end(); }
+    inline size_t size() const { return m_rooms.size(); }
+
+private:
+    /// copy of a body & its shapes in another room
+    struct Ghost {
+        Room* room;
+        cpBody* body;
+        std::vector<cpShape*> shapes{};
+    };
+
+    static Key key(int32_t x, int32_t y);
+    static std::pair<int32_t, int32_t> coords(Key);
+    static void sync(cpBody*, Ghost&);
+    Ghost ghost(cpBody*, Room&);
+    static void destroy(Ghost&);
+    void set_lod(Room&, room_lod);
+    void sleep(cpBody*);
+    void wake(cpBody*);
+
+    entt::registry& m_ecs;
+    std::unordered_map<Key, std::unique_ptr<Room>> m_rooms{};
+    std::unordered_map<cpBody*, std::vector<Ghost>> m_ghosts{};
+    std::vector<Room*> m_step{};    // reused between steps
+};
+
+} // namespace physics
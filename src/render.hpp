@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
 #include <entt/fwd.hpp>
 #include <chipmunk/chipmunk_types.h>
 #include <glm/glm.hpp>
 #include "render/plugin.hpp"
+#include "render/sprite_frames.hpp"
 #include "physics.hpp"
 
 namespace render {
@@ -12,8 +15,34 @@ constexpr cpVect RESOLUTION{320, 176};
 constexpr cpVect CAMERA_ACCEL{RESOLUTION / 1.0};
 constexpr cpVect TILE_SIZE{16, 16};
 
+/// get the coordinates of the screen-sized chunk containing a position
+///
+/// Geometry that is uploaded once, like the static layer, is grouped into
+/// chunks so only those overlapping the camera are drawn.
+inline glm::ivec2
+chunk_coords(glm::vec2 pos)
+{
+    return { static_cast<int32_t>(std::floor(pos.x / RESOLUTION.x)),
+        static_cast<int32_t>(std::floor(pos.y / RESOLUTION.y)) };
+}
+
+/// get a hashable key for the chunk containing a position
+inline uint64_t
+chunk_key(glm::vec2 pos)
+{
+    auto c = chunk_coords(pos);
+    return static_cast<uint64_t>(static_cast<uint32_t>(c.x)) << 32
+        | static_cast<uint32_t>(c.y);
+}
+
 struct Camera {};
 
+/// tag for sprites that never move or change, such as background tiles
+///
+/// Static sprites are baked into render::StaticLayer instead of being drawn
+/// every frame, and are always drawn beneath all other sprites.
+struct Static {};
+
 /// position of top-left corner of rendered entity
 struct Translate {
     Translate(glm::vec2& p) : v{p} {};
@@ -36,8 +65,7 @@ struct Translate {
 /// sprite to render
 struct Sprite {
     glm::vec2 res;  // resolution of sprite on screen
-    sg_image img;   // image source for sprite
-    glm::mat3 crop; // crop of img to render
+    FrameId frame;  // texture & crop to render, from SpriteFrames
 };
 
 } // namespace render
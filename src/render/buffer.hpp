@@ -18,11 +18,23 @@ public:
     }
     inline void clear() { m_data.clear(); }
     inline void reserve(size_t count) { m_data.reserve(count); }
+    inline void resize(size_t count) { m_data.resize(count); }
+
+    /// append `count` elements for the caller to fill in, returns the first
+    inline T* extend(size_t count) {
+        size_t first = m_data.size();
+        m_data.resize(first + count);
+        return m_data.data() + first;
+    }
 
     inline T& at(size_t pos) {
         assert(pos < m_data.size());
         return m_data[pos];
     }
+    inline const T& at(size_t pos) const {
+        assert(pos < m_data.size());
+        return m_data[pos];
+    }
 
     virtual const sg_range sg_range() const {
         return { .ptr = data(), .size = size() };
@@ -0,0 +1,141 @@
+#include <cerrno>
+#include <cstring>
+#include "../log.hpp"
+#include "capture.hpp"
+
+namespace render::capture {
+
+static constexpr char MAGIC[4] = { 'R', 'C', 'A', 'P' };
+static constexpr uint32_t VERSION = 3;
+
+template <typename T>
+static inline bool
+write_vector(std::FILE* file, const std::vector<T>& v)
+{
+    return v.empty()
+        || std::fwrite(v.data(), sizeof(T), v.size(), file) == v.size();
+}
+
+template <typename T>
+static inline bool
+read_vector(std::FILE* file, std::vector<T>& v, uint32_t count)
+{
+    v.resize(count);
+    return count == 0 || std::fread(v.data(), sizeof(T), count, file) == count;
+}
+
+uint32_t
+Frame::texture(uint32_t id, int32_t width, int32_t height)
+{
+    for (uint32_t i = 0; i < textures.size(); i++) {
+        if (textures[i].id == id) {
+            return i;
+        }
+    }
+    textures.push_back({ id, width, height });
+    return textures.size() - 1;
+}
+
+Writer::~Writer()
+{
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+    }
+}
+
+bool
+Writer::open(const char* path)
+{
+    m_file = std::fopen(path, "wb");
+    if (m_file == nullptr) {
+        log_errno("failed to open capture file {}", path);
+        return false;
+    }
+    std::fwrite(MAGIC, sizeof(MAGIC), 1, m_file);
+    std::fwrite(&VERSION, sizeof(VERSION), 1, m_file);
+    return true;
+}
+
+bool
+Writer::write(Frame& frame)
+{
+    auto& h = frame.header;
+    h.textures = frame.textures.size();
+    h.rects = frame.rects.size();
+    h.sprites = frame.sprites.size();
+    h.layers = frame.layers.size();
+    h.opaque = frame.opaque.size();
+    h.lines = frame.lines.size();
+
+    bool ok = std::fwrite(&h, sizeof(h), 1, m_file) == 1
+        && write_vector(m_file, frame.textures)
+        && write_vector(m_file, frame.rects)
+        && write_vector(m_file, frame.sprites)
+        && write_vector(m_file, frame.layers)
+        && write_vector(m_file, frame.opaque)
+        && write_vector(m_file, frame.lines);
+    if (!ok) {
+        log_errno("failed to write capture frame");
+    }
+    return ok;
+}
+
+Reader::~Reader()
+{
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+    }
+}
+
+bool
+Reader::open(const char* path)
+{
+    m_file = std::fopen(path, "rb");
+    if (m_file == nullptr) {
+        log_errno("failed to open capture file {}", path);
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version;
+    if (std::fread(magic, sizeof(magic), 1, m_file) != 1
+        || std::fread(&version, sizeof(version), 1, m_file) != 1
+        || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        log_error("{} is not a capture file", path);
+        return false;
+    }
+    if (version != VERSION) {
+        log_error("capture file {} is version {}, expected {}", path,
+            version, VERSION);
+        return false;
+    }
+    m_start = std::ftell(m_file);
+    return true;
+}
+
+bool
+Reader::read(Frame& frame)
+{
+    auto& h = frame.header;
+    if (std::fread(&h, sizeof(h), 1, m_file) != 1) {
+        return false;
+    }
+    bool ok = read_vector(m_file, frame.textures, h.textures)
+        && read_vector(m_file, frame.rects, h.rects)
+        && read_vector(m_file, frame.sprites, h.sprites)
+        && read_vector(m_file, frame.layers, h.layers)
+        && read_vector(m_file, frame.opaque, h.opaque)
+        && read_vector(m_file, frame.lines, h.lines);
+    if (!ok) {
+        log_error("truncated capture frame");
+    }
+    return ok;
+}
+
+void
+Reader::rewind()
+{
+    std::fseek(m_file, m_start, SEEK_SET);
+}
+
+} // namespace render::capture
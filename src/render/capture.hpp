@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <glm/glm.hpp>
+#include "rgba.hpp"
+
+namespace render::capture {
+
+/// texture referenced by a captured frame; replay substitutes a blank image
+/// of the same size
+struct Texture {
+    uint32_t id;
+    int32_t width;
+    int32_t height;
+};
+
+/// a quad as passed to QuadRenderer::draw_rect() or draw_sprite(); pos is
+/// relative to the frame's origin, and texture indexes Frame::textures, or
+/// is the layer for draw_layer() & draw_opaque_layer()
+struct Quad {
+    glm::vec<2, int16_t> pos;
+    glm::vec<2, int16_t> size;
+    glm::vec4 uv;   // top-left & size of the crop, normalized
+    uint32_t texture;
+    int32_t z;      // 0 for draw_rect()
+};
+
+/// a segment as passed to LineRenderer::draw_seg()
+struct Line {
+    glm::vec2 a;
+    glm::vec2 b;
+    rgba color;
+};
+
+/// everything submitted to the QuadRenderer & LineRenderer for a frame
+///
+/// Retained sprites are included with the opaque quads, rebased onto the
+/// frame's origin; the static layer, which is only kept on the GPU, is not.
+struct Frame {
+    struct Header {
+        glm::vec4 clear;        // pass clear color
+        int32_t width;          // framebuffer size
+        int32_t height;
+        glm::mat4 quad_proj;    // QuadRenderer::View
+        glm::vec2 camera;
+        glm::ivec2 origin;      // QuadRenderer::origin()
+        glm::mat4 line_proj;
+        uint32_t layer_texture; // texture array used by `layers` & `opaque`
+        uint32_t textures;      // element counts of the vectors below
+        uint32_t rects;
+        uint32_t sprites;
+        uint32_t layers;
+        uint32_t opaque;
+        uint32_t lines;
+    } header{};
+
+    std::vector<Texture> textures{};
+    std::vector<Quad> rects{};      // drawn with draw_rect()
+    std::vector<Quad> sprites{};    // drawn with draw_sprite()
+    std::vector<Quad> layers{};     // drawn with draw_layer()
+    std::vector<Quad> opaque{};     // drawn with draw_opaque_layer()
+    std::vector<Line> lines{};
+
+    /// get the index of a texture in `textures`, adding it if needed
+    uint32_t texture(uint32_t id, int32_t width, int32_t height);
+};
+
+/// capture file writer
+///
+/// The file is a small header followed by each Frame: its Header, then the
+/// raw contents of each vector.  It is only meant to be read back on the
+/// same architecture.
+class Writer {
+public:
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    ~Writer();
+
+    bool open(const char* path);
+    bool write(Frame&);
+    inline bool is_open() const { return m_file != nullptr; }
+
+private:
+    std::FILE* m_file{ nullptr };
+};
+
+/// capture file reader
+class Reader {
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    ~Reader();
+
+    bool open(const char* path);
+
+    /// read the next frame; returns false at the end of the file
+    bool read(Frame&);
+
+    /// go back to the first frame
+    void rewind();
+
+private:
+    std::FILE* m_file{ nullptr };
+    long m_start{ 0 };
+};
+
+} // namespace render::capture
@@ -0,0 +1,126 @@
+#include <cassert>
+#include "frame_stats.hpp"
+
+namespace render {
+
+FrameStats::FrameStats()
+{
+    sg_trace_hooks hooks{
+        .user_data = this,
+        .make_buffer = on_make_buffer,
+        .destroy_buffer = on_destroy_buffer,
+        .update_buffer = on_update_buffer,
+        .append_buffer = on_append_buffer,
+        .begin_default_pass = on_begin_default_pass,
+        .begin_pass = on_begin_pass,
+        .apply_pipeline = on_apply_pipeline,
+        .apply_bindings = on_apply_bindings,
+        .apply_uniforms = on_apply_uniforms,
+        .draw = on_draw,
+        .commit = on_commit,
+    };
+    [[maybe_unused]] sg_trace_hooks prev = sg_install_trace_hooks(&hooks);
+    assert(prev.user_data == nullptr && prev.draw == nullptr
+        && "FrameStats must be installed before any other trace hooks");
+}
+
+void
+FrameStats::upload(sg_buffer buf, size_t bytes)
+{
+    m_current.uploads++;
+    auto it = m_buffer_types.find(buf.id);
+    if (it != m_buffer_types.end() && it->second == SG_BUFFERTYPE_INDEXBUFFER) {
+        m_current.index_bytes += bytes;
+    } else {
+        m_current.vertex_bytes += bytes;
+    }
+}
+
+void
+FrameStats::on_make_buffer(const sg_buffer_desc* desc, sg_buffer buf,
+    void* data)
+{
+    auto self = static_cast<FrameStats*>(data);
+    self->m_buffer_types[buf.id] =
+        desc->type == SG_BUFFERTYPE_INDEXBUFFER ? SG_BUFFERTYPE_INDEXBUFFER
+                                                : SG_BUFFERTYPE_VERTEXBUFFER;
+}
+
+void
+FrameStats::on_destroy_buffer(sg_buffer buf, void* data)
+{
+    static_cast<FrameStats*>(data)->m_buffer_types.erase(buf.id);
+}
+
+void
+FrameStats::on_update_buffer(sg_buffer buf, const sg_range* range, void* data)
+{
+    static_cast<FrameStats*>(data)->upload(buf, range->size);
+}
+
+void
+FrameStats::on_append_buffer(sg_buffer buf, const sg_range* range, int,
+    void* data)
+{
+    static_cast<FrameStats*>(data)->upload(buf, range->size);
+}
+
+void
+FrameStats::on_begin_default_pass(const sg_pass_action*, int, int, void* data)
+{
+    static_cast<FrameStats*>(data)->m_current.passes++;
+}
+
+void
+FrameStats::on_begin_pass(sg_pass, const sg_pass_action*, void* data)
+{
+    static_cast<FrameStats*>(data)->m_current.passes++;
+}
+
+void
+FrameStats::on_apply_pipeline(sg_pipeline, void* data)
+{
+    static_cast<FrameStats*>(data)->m_current.pipelines++;
+}
+
+void
+FrameStats::on_apply_bindings(const sg_bindings* bindings, void* data)
+{
+    auto self = static_cast<FrameStats*>(data);
+    self->m_current.bindings++;
+    self->m_indexed = bindings->index_buffer.id != SG_INVALID_ID;
+}
+
+void
+FrameStats::on_apply_uniforms(
+    sg_shader_stage, int, const sg_range* range, void* data)
+{
+    auto self = static_cast<FrameStats*>(data);
+    self->m_current.uniforms++;
+    self->m_current.uniform_bytes += range->size;
+}
+
+void
+FrameStats::on_draw(int, int elements, int instances, void* data)
+{
+    auto self = static_cast<FrameStats*>(data);
+    auto& c = self->m_current;
+    c.draws++;
+    c.instances += instances;
+    uint64_t count = static_cast<uint64_t>(elements) * instances;
+    if (self->m_indexed) {
+        c.indices += count;
+    } else {
+        c.vertices += count;
+    }
+}
+
+void
+FrameStats::on_commit(void* data)
+{
+    auto self = static_cast<FrameStats*>(data);
+    self->m_last = self->m_current;
+    self->m_current = { .frame = self->m_last.frame + 1 };
+}
+
+} // namespace render
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <sokol_gfx.h>
+
+namespace render {
+
+/// per-frame counts of sokol-gfx calls, collected with SOKOL_TRACE_HOOKS
+///
+/// Counts cover every call made through sokol-gfx, including ImGui, so they
+/// show exactly what reaches the GPU without any GPU timers.  A frame ends
+/// at sg_commit().
+///
+/// The hooks must be installed before any others, such as sg_imgui's, which
+/// then chain to these.  They are never uninstalled, so a FrameStats must
+/// outlive every sokol-gfx call; the render plugin creates it right after
+/// sg_setup(), and drops it after sg_shutdown().
+class FrameStats {
+public:
+    struct Counts {
+        uint64_t frame{ 0 };
+        uint32_t passes{ 0 };
+        uint32_t pipelines{ 0 };    // sg_apply_pipeline() calls
+        uint32_t bindings{ 0 };     // sg_apply_bindings() calls
+        uint32_t uniforms{ 0 };     // sg_apply_uniforms() calls
+        uint32_t draws{ 0 };
+        uint64_t vertices{ 0 };     // drawn without an index buffer
+        uint64_t indices{ 0 };      // drawn with an index buffer
+        uint64_t instances{ 0 };
+        uint32_t uploads{ 0 };      // sg_append_buffer() & sg_update_buffer()
+        uint64_t vertex_bytes{ 0 }; // uploaded to vertex buffers
+        uint64_t index_bytes{ 0 };  // uploaded to index buffers
+        uint64_t uniform_bytes{ 0 };
+    };
+
+    FrameStats();
+    FrameStats(const FrameStats&) = delete;
+
+    /// counts for the last completed frame
+    inline const Counts& last() const { return m_last; }
+
+private:
+    static void on_make_buffer(const sg_buffer_desc*, sg_buffer, void*);
+    static void on_destroy_buffer(sg_buffer, void*);
+    static void on_update_buffer(sg_buffer, const sg_range*, void*);
+    static void on_append_buffer(sg_buffer, const sg_range*, int, void*);
+    static void on_begin_default_pass(const sg_pass_action*, int, int, void*);
+    static void on_begin_pass(sg_pass, const sg_pass_action*, void*);
+    static void on_apply_pipeline(sg_pipeline, void*);
+    static void on_apply_bindings(const sg_bindings*, void*);
+    static void on_apply_uniforms(
+        sg_shader_stage, int, const sg_range*, void*);
+    static void on_draw(int, int, int, void*);
+    static void on_commit(void*);
+
+    void upload(sg_buffer, size_t bytes);
+
+    Counts m_current{};
+    Counts m_last{};
+    bool m_indexed{ false };    // last bindings had an index buffer
+    std::unordered_map<uint32_t, sg_buffer_type> m_buffer_types{};
+};
+
+} // namespace render
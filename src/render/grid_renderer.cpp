@@ -0,0 +1,68 @@
+#include "grid_renderer.hpp"
+#include "shaders/grid.glsl.h"
+#include "shader_backend.hpp"
+#include "../log.hpp"
+
+namespace render {
+
+GridRenderer::GridRenderer()
+{
+    m_shader = sg_make_shader(grid_shader_desc(shader_backend()));
+    sg_pipeline_desc desc = {
+        .shader = m_shader,
+        .layout = {
+            .attrs = {
+                [ATTR_vs_v_pos].format = SG_VERTEXFORMAT_FLOAT2,
+            },
+        },
+        .colors[0].blend = {
+            .enabled = true,
+            .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
+            .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        },
+        .label = "GridRenderer",
+    };
+    m_pipeline = sg_make_pipeline(&desc);
+
+    // a single triangle that covers the whole screen
+    const glm::vec2 vertices[] = { { -1, -1 }, { 3, -1 }, { -1, 3 } };
+    sg_buffer_desc vb_desc = {
+        .type = SG_BUFFERTYPE_VERTEXBUFFER,
+        .data = SG_RANGE(vertices),
+        .label = "GridRenderer::m_vb",
+    };
+    m_vb = sg_make_buffer(&vb_desc);
+}
+
+GridRenderer::~GridRenderer()
+{
+    log_debug("destroy shader {}, pipeline {}, vb {}", m_shader.id,
+        m_pipeline.id, m_vb.id);
+    sg_destroy_buffer(m_vb);
+    sg_destroy_pipeline(m_pipeline);
+    sg_destroy_shader(m_shader);
+}
+
+void
+GridRenderer::render(glm::vec2 camera, glm::vec2 resolution, glm::vec2 tile,
+    glm::vec2 offset, rgba color)
+{
+    sg_apply_pipeline(m_pipeline);
+
+    // only the camera's position within a cell reaches the shader, so the
+    // grid stays exact however far the camera is from the world origin
+    fs_params_t params{
+        .u_color = glm::vec4(color) / 255.0f,
+        .u_phase = glm::mod(camera - offset, tile),
+        .u_resolution = resolution,
+        .u_tile = tile,
+    };
+    sg_range p = SG_RANGE(params);
+    sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_fs_params, &p);
+
+    sg_bindings bind{ .vertex_buffers[0] = m_vb };
+    sg_apply_bindings(&bind);
+    sg_draw(0, 3, 1);
+}
+
+} // namespace render
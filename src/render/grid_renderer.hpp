@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include "rgba.hpp"
+
+namespace render {
+
+/// tile grid drawn by a single fullscreen shader pass
+///
+/// Nothing is generated on the CPU; the fragment shader finds the grid lines
+/// from the world position of each pixel, so the cost is the same no matter
+/// how many lines are on screen.
+class GridRenderer
+{
+public:
+    GridRenderer();
+    GridRenderer(const GridRenderer&) = delete;
+    ~GridRenderer();
+
+    /// draw the grid over the screen at the camera position; `offset` is the
+    /// position of any one grid line
+    void render(glm::vec2 camera, glm::vec2 resolution, glm::vec2 tile,
+        glm::vec2 offset, rgba color);
+
+private:
+    sg_pipeline m_pipeline;
+    sg_shader m_shader;
+    sg_buffer m_vb;
+};
+
+} // namespace render
@@ -0,0 +1,84 @@
+#include <cassert>
+#include "../log.hpp"
+#include "../render.hpp"
+#include "line_layer.hpp"
+
+namespace render {
+
+LineLayer::~LineLayer()
+{
+    clear();
+}
+
+void
+LineLayer::clear()
+{
+    for (auto& [key, chunk] : m_chunks) {
+        LineRenderer::destroy(chunk.mesh);
+    }
+    m_chunks.clear();
+}
+
+LineLayer::Chunk&
+LineLayer::chunk(glm::vec2 min, glm::vec2 max)
+{
+    auto [it, added] = m_chunks.try_emplace(chunk_key(min));
+    Chunk& chunk = it->second;
+    if (added) {
+        chunk.min = min;
+        chunk.max = max;
+    } else {
+        chunk.min = glm::min(chunk.min, min);
+        chunk.max = glm::max(chunk.max, max);
+    }
+
+    // chunks are drawn with 16-bit indices
+    assert(chunk.v.elements() + 4 <= (1 << 16)
+        && "too many lines in a single chunk");
+    return chunk;
+}
+
+void
+LineLayer::draw_rect(glm::vec2 pos, glm::vec2 size, rgba color)
+{
+    auto& c = chunk(pos, pos + size);
+    LineRenderer::rect(c.v, c.i, pos, size, color);
+}
+
+void
+LineLayer::draw_seg(glm::vec2 a, glm::vec2 b, rgba color)
+{
+    auto& c = chunk(glm::min(a, b), glm::max(a, b));
+    LineRenderer::seg(c.v, c.i, a, b, color);
+}
+
+void
+LineLayer::bake()
+{
+    for (auto& [key, chunk] : m_chunks) {
+        if (chunk.i.elements() == 0) {
+            continue;
+        }
+        LineRenderer::destroy(chunk.mesh);
+        chunk.mesh = LineRenderer::bake(chunk.v, chunk.i);
+        chunk.v = {};
+        chunk.i = {};
+    }
+    log_debug("baked {} line chunks", m_chunks.size());
+}
+
+void
+LineLayer::render(LineRenderer& lines, const glm::mat4& proj, glm::vec2 camera)
+{
+    glm::vec2 max{ camera.x + RESOLUTION.x, camera.y + RESOLUTION.y };
+
+    for (auto& [key, chunk] : m_chunks) {
+        if (chunk.max.x < camera.x || chunk.min.x > max.x
+            || chunk.max.y < camera.y || chunk.min.y > max.y) {
+            continue;
+        }
+        lines.render(proj, chunk.mesh);
+    }
+}
+
+} // namespace render
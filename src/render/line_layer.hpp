@@ -0,0 +1,52 @@
+#pragma once
+
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "line_renderer.hpp"
+
+namespace render {
+
+/// retained lines, uploaded once & drawn every frame until rebuilt
+///
+/// Lines are grouped into screen-sized chunks by position, and each chunk is
+/// baked into immutable GPU buffers by bake().  Only the chunks overlapping
+/// the camera are drawn, so the cost of a frame doesn't grow with the size of
+/// the map.  Used for debug geometry that rarely changes, like static
+/// physics shapes.
+class LineLayer {
+public:
+    LineLayer() = default;
+    LineLayer(const LineLayer&) = delete;
+    ~LineLayer();
+
+    /// remove all lines, both drawn & baked
+    void clear();
+
+    /// add lines to the chunk containing their top-left corner
+    void draw_rect(glm::vec2 pos, glm::vec2 size, rgba color);
+    void draw_seg(glm::vec2 a, glm::vec2 b, rgba color);
+
+    /// upload the lines drawn since clear()
+    void bake();
+
+    /// draw the chunks overlapping the screen at the camera position
+    void render(LineRenderer&, const glm::mat4&, glm::vec2 camera);
+
+    inline size_t chunks() const { return m_chunks.size(); }
+
+private:
+    struct Chunk {
+        Buffer<LineRenderer::Vertex> v{};   // released by bake()
+        IndexBuffer i{};
+        LineRenderer::Mesh mesh{};
+        glm::vec2 min{ 0 };     // bounds of the lines in the chunk
+        glm::vec2 max{ 0 };
+    };
+
+    /// get the chunk for lines in the bounds, and grow its bounds to fit
+    Chunk& chunk(glm::vec2 min, glm::vec2 max);
+
+    std::unordered_map<uint64_t, Chunk> m_chunks{};
+};
+
+} // namespace render
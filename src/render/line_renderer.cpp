@@ -1,15 +1,20 @@
 #include "line_renderer.hpp"
+#include "capture.hpp"
 #include "shaders/line.glsl.h"
+#include "shader_backend.hpp"
 #include "../log.hpp"
 
+#include <cassert>
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace render {
 
 LineRenderer::LineRenderer(size_t v_max, size_t i_max)
+    : m_buf{
+        { SG_BUFFERTYPE_VERTEXBUFFER, v_max, "LineRenderer::m_buf.v" },
+        { SG_BUFFERTYPE_INDEXBUFFER, i_max, "LineRenderer::m_buf.i" },
+      }
 {
-    assert(v_max < (2<<16) && "v_max exceeds uint16 index buffer");
-
     /* create a pipeline object (default render state is fine) */
     m_pipeline_desc = {
         .label = "LineRenderer",
@@ -28,31 +33,16 @@ LineRenderer::LineRenderer(size_t v_max, size_t i_max)
         },
     };
 
-    m_shader = sg_make_shader(line_shader_desc(sg_query_backend()));
+    m_shader = sg_make_shader(line_shader_desc(shader_backend()));
     m_pipeline_desc.shader = m_shader;
     m_pipeline = sg_make_pipeline(&m_pipeline_desc);
-
-    m_vb_desc = {
-        .type = SG_BUFFERTYPE_VERTEXBUFFER,
-        .usage = SG_USAGE_DYNAMIC,
-        .size = v_max * sizeof(Vertex),
-    };
-    m_vb = sg_make_buffer(&m_vb_desc);
-
-    m_ib_desc = {
-        .type = SG_BUFFERTYPE_INDEXBUFFER,
-        .usage = SG_USAGE_DYNAMIC,
-        .size = i_max * sizeof(uint16_t),
-    };
-    m_ib = sg_make_buffer(&m_ib_desc);
 }
 
 LineRenderer::~LineRenderer()
 {
     log_debug("destroy shader {}, pipeline {}, ib {}, vb {}",
-            m_shader.id, m_pipeline.id, m_ib.id, m_vb.id);
-    sg_destroy_buffer(m_ib);
-    sg_destroy_buffer(m_vb);
+            m_shader.id, m_pipeline.id, m_buf.i.buffer().id,
+            m_buf.v.buffer().id);
     sg_destroy_pipeline(m_pipeline);
     sg_destroy_shader(m_shader);
 }
@@ -62,32 +52,131 @@ LineRenderer::clear()
 {
     m_buf.v.clear();
     m_buf.i.clear();
+    m_batches.assign(1, { 0, 0 });
+}
+
+size_t
+LineRenderer::batch(size_t vertices)
+{
+    size_t first = m_batches.back().vertex;
+    if (m_buf.v.elements() + vertices - first > (1 << 16)) {
+        m_batches.push_back({ m_buf.v.elements(), m_buf.i.elements() });
+        first = m_buf.v.elements();
+    }
+    return first;
+}
+
+void
+LineRenderer::draw(sg_buffer vb, int vb_offset, sg_buffer ib, int ib_offset,
+    size_t elements)
+{
+    sg_bindings bind{
+        .vertex_buffers[0] = vb,
+        .vertex_buffer_offsets[0] = vb_offset,
+        .index_buffer = ib,
+        .index_buffer_offset = ib_offset,
+    };
+    sg_apply_bindings(&bind);
+    sg_draw(0, elements, 1);
 }
 
 void
 LineRenderer::render(const glm::mat4& proj)
 {
+    // upload even when empty, to keep the utilization stats current
+    int vb_offset = m_buf.v.upload();
+    int ib_offset = m_buf.i.upload();
     if (m_buf.i.size() == 0) {
         return;
     }
     sg_apply_pipeline(m_pipeline);
 
     sg_range p = SG_RANGE(proj);
-    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &p);    // XXX magic number
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &p);
+
+    // each batch's indices are relative to its first vertex, so it's bound
+    // from there
+    for (size_t n = 0; n < m_batches.size(); n++) {
+        const auto& b = m_batches[n];
+        size_t end = n + 1 < m_batches.size() ? m_batches[n + 1].index
+                                              : m_buf.i.elements();
+        draw(m_buf.v.buffer(),
+            vb_offset + static_cast<int>(b.vertex * sizeof(Vertex)),
+            m_buf.i.buffer(),
+            ib_offset + static_cast<int>(b.index * sizeof(uint16_t)),
+            end - b.index);
+    }
+}
 
-    sg_bindings bind{
-        .vertex_buffers[0] = m_vb,
-        .vertex_buffer_offsets[0] = sg_append_buffer(m_vb, m_buf.v.sg_range()),
-        .index_buffer = m_ib,
-        .index_buffer_offset = sg_append_buffer(m_ib, m_buf.i.sg_range()),
+void
+LineRenderer::render(const glm::mat4& proj, const Mesh& mesh)
+{
+    if (mesh.elements == 0) {
+        return;
+    }
+    sg_apply_pipeline(m_pipeline);
+
+    sg_range p = SG_RANGE(proj);
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &p);
+
+    draw(mesh.vb, 0, mesh.ib, 0, mesh.elements);
+}
+
+LineRenderer::Mesh
+LineRenderer::bake(const Buffer<Vertex>& v, const IndexBuffer& i)
+{
+    Mesh mesh{};
+    if (i.size() == 0) {
+        return mesh;
+    }
+
+    sg_buffer_desc vb_desc = {
+        .type = SG_BUFFERTYPE_VERTEXBUFFER,
+        .usage = SG_USAGE_IMMUTABLE,
+        .data = v.sg_range(),
+        .label = "LineRenderer::Mesh::vb",
     };
-    sg_apply_bindings(&bind);
-    sg_draw(0, m_buf.i.elements(), 1);
+    sg_buffer_desc ib_desc = {
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .usage = SG_USAGE_IMMUTABLE,
+        .data = i.sg_range(),
+        .label = "LineRenderer::Mesh::ib",
+    };
+    mesh.vb = sg_make_buffer(&vb_desc);
+    mesh.ib = sg_make_buffer(&ib_desc);
+    mesh.elements = i.elements();
+    return mesh;
+}
+
+void
+LineRenderer::destroy(Mesh& mesh)
+{
+    if (mesh.elements == 0) {
+        return;
+    }
+    sg_destroy_buffer(mesh.ib);
+    sg_destroy_buffer(mesh.vb);
+    mesh = {};
 }
 
 void
 LineRenderer::draw_rect(glm::vec2 pos, glm::vec2 size, rgba color)
 {
+    rect(m_buf.v, m_buf.i, pos, size, color, batch(4));
+}
+
+void
+LineRenderer::draw_seg(glm::vec2 a, glm::vec2 b, rgba color)
+{
+    seg(m_buf.v, m_buf.i, a, b, color, batch(2));
+}
+
+void
+LineRenderer::rect(Buffer<Vertex>& v, IndexBuffer& i, glm::vec2 pos,
+    glm::vec2 size, rgba color, size_t first)
+{
+    assert(v.elements() + 4 - first <= (1 << 16)
+        && "line vertices exceed uint16 indices");
     static const glm::vec3 quad[] = {
         {  0.0f,  0.0f, 1.0f },
         {  1.0f,  0.0f, 1.0f },
@@ -101,11 +190,11 @@ LineRenderer::draw_rect(glm::vec2 pos, glm::vec2 size, rgba color)
         { static_cast<float>(pos.x), static_cast<float>(pos.y), 1.0f },
     };
 
-    uint16_t base = m_buf.v.elements();
-    for (int i = 0; i < 4; i++) {
-        m_buf.v.push_back({ transform * quad[i], color});
+    uint16_t base = v.elements() - first;
+    for (int n = 0; n < 4; n++) {
+        v.push_back({ transform * quad[n], color});
     }
-    m_buf.i.append({
+    i.append({
             (uint16_t)(base + 0), (uint16_t)(base + 1),
             (uint16_t)(base + 1), (uint16_t)(base + 2),
             (uint16_t)(base + 2), (uint16_t)(base + 3),
@@ -114,11 +203,29 @@ LineRenderer::draw_rect(glm::vec2 pos, glm::vec2 size, rgba color)
 }
 
 void
-LineRenderer::draw_seg(glm::vec2 a, glm::vec2 b, rgba color)
+LineRenderer::seg(Buffer<Vertex>& v, IndexBuffer& i, glm::vec2 a, glm::vec2 b,
+    rgba color, size_t first)
 {
-    uint16_t base = m_buf.v.elements();
-    m_buf.v.append({ { a, color }, { b, color }});
-    m_buf.i.append({ (uint16_t)(base + 0), (uint16_t)(base + 1), });
+    assert(v.elements() + 2 - first <= (1 << 16)
+        && "line vertices exceed uint16 indices");
+    uint16_t base = v.elements() - first;
+    v.append({ { a, color }, { b, color }});
+    i.append({ (uint16_t)(base + 0), (uint16_t)(base + 1), });
+}
+
+void
+LineRenderer::capture(capture::Frame& frame) const
+{
+    for (size_t k = 0; k < m_batches.size(); k++) {
+        const auto& batch = m_batches[k];
+        size_t end = k + 1 < m_batches.size() ? m_batches[k + 1].index
+                                              : m_buf.i.elements();
+        for (size_t n = batch.index; n + 1 < end; n += 2) {
+            const Vertex& a = m_buf.v.at(batch.vertex + m_buf.i.at(n));
+            const Vertex& b = m_buf.v.at(batch.vertex + m_buf.i.at(n + 1));
+            frame.lines.push_back({ a.pos, b.pos, a.color });
+        }
+    }
 }
 
 } // namespace render
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <sokol_gfx.h>
 #include "rgba.hpp"
 #include "buffer.hpp"
+#include "stream_buffer.hpp"
 
 namespace render {
 
+namespace capture { struct Frame; }
+
 class LineRenderer
 {
 public:
@@ -19,8 +23,21 @@ public:
     };
 
     struct BufferPair {
-        Buffer<Vertex> v;
-        IndexBuffer i;
+        StreamBuffer<Vertex> v;
+        StreamBuffer<uint16_t> i;
+    };
+
+    /// lines uploaded once into immutable GPU buffers; see LineLayer
+    struct Mesh {
+        sg_buffer vb{};
+        sg_buffer ib{};
+        size_t elements{ 0 };
+    };
+
+    /// buffer utilization from the last call to render()
+    struct Stats {
+        StreamStats vertices{};
+        StreamStats indices{};
     };
 
 
@@ -30,16 +47,47 @@ public:
     ~LineRenderer();
     void clear();
     void render(const glm::mat4&);
+    void render(const glm::mat4&, const Mesh&);
     void draw_rect(glm::vec2 pos, glm::vec2 size, rgba color);
     void draw_seg(glm::vec2 a, glm::vec2 b, rgba color);
 
+    /// append the lines for a rect or segment to a pair of buffers
+    ///
+    /// Indices are relative to vertex `first`, and must fit in 16 bits; the
+    /// caller starts a new batch of vertices before they would not.
+    static void rect(Buffer<Vertex>&, IndexBuffer&, glm::vec2 pos,
+        glm::vec2 size, rgba color, size_t first = 0);
+    static void seg(Buffer<Vertex>&, IndexBuffer&, glm::vec2 a, glm::vec2 b,
+        rgba color, size_t first = 0);
+
+    /// upload lines into an immutable Mesh; release it with destroy()
+    static Mesh bake(const Buffer<Vertex>&, const IndexBuffer&);
+    static void destroy(Mesh&);
+
+    inline Stats stats() const { return { m_buf.v.stats(), m_buf.i.stats() }; }
+
+    /// append the lines drawn since the last clear() to a capture frame
+    void capture(capture::Frame&) const;
+
 private:
+    /// lines whose indices are relative to the same vertex
+    struct Batch {
+        size_t vertex;  // first vertex & index in m_buf
+        size_t index;
+    };
+
+    void draw(sg_buffer vb, int vb_offset, sg_buffer ib, int ib_offset,
+        size_t elements);
+
+    /// start a new batch if `vertices` more wouldn't fit in 16-bit indices
+    /// of the current one; returns the current batch's first vertex
+    size_t batch(size_t vertices);
+
     sg_pipeline_desc m_pipeline_desc;
     sg_pipeline m_pipeline;
     sg_shader m_shader;
-    sg_buffer_desc m_vb_desc, m_ib_desc;
-    sg_buffer m_vb, m_ib;
     BufferPair m_buf;
+    std::vector<Batch> m_batches{ { 0, 0 } };
 };
 
 } // namespace render
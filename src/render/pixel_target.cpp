@@ -0,0 +1,118 @@
+#include <algorithm>
+#include "pixel_target.hpp"
+#include "shaders/blit.glsl.h"
+#include "shader_backend.hpp"
+#include "../log.hpp"
+
+namespace render {
+
+PixelTarget::PixelTarget(glm::ivec2 size)
+    : m_size{ size }
+{
+    // pixel formats are left to the defaults, which match the default
+    // framebuffer, so the same pipelines draw into either
+    sg_image_desc color_desc = {
+        .render_target = true,
+        .width = size.x,
+        .height = size.y,
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "PixelTarget::m_color",
+    };
+    m_color = sg_make_image(&color_desc);
+
+    sg_image_desc depth_desc = {
+        .render_target = true,
+        .width = size.x,
+        .height = size.y,
+        .pixel_format = SG_PIXELFORMAT_DEPTH_STENCIL,
+        .label = "PixelTarget::m_depth",
+    };
+    m_depth = sg_make_image(&depth_desc);
+
+    sg_pass_desc pass_desc = {
+        .color_attachments[0].image = m_color,
+        .depth_stencil_attachment.image = m_depth,
+        .label = "PixelTarget::m_pass",
+    };
+    m_pass = sg_make_pass(&pass_desc);
+
+    m_shader = sg_make_shader(blit_shader_desc(shader_backend()));
+    sg_pipeline_desc desc = {
+        .shader = m_shader,
+        .layout = {
+            .attrs = {
+                [ATTR_vs_v_pos].format = SG_VERTEXFORMAT_FLOAT2,
+            },
+        },
+        .label = "PixelTarget::m_pipeline",
+    };
+    m_pipeline = sg_make_pipeline(&desc);
+
+    // a single triangle that covers the whole viewport
+    const glm::vec2 vertices[] = { { -1, -1 }, { 3, -1 }, { -1, 3 } };
+    sg_buffer_desc vb_desc = {
+        .type = SG_BUFFERTYPE_VERTEXBUFFER,
+        .data = SG_RANGE(vertices),
+        .label = "PixelTarget::m_vb",
+    };
+    m_vb = sg_make_buffer(&vb_desc);
+}
+
+PixelTarget::~PixelTarget()
+{
+    log_debug("destroy pass {}, images {} {}, shader {}, pipeline {}, vb {}",
+        m_pass.id, m_color.id, m_depth.id, m_shader.id, m_pipeline.id,
+        m_vb.id);
+    sg_destroy_buffer(m_vb);
+    sg_destroy_pipeline(m_pipeline);
+    sg_destroy_shader(m_shader);
+    sg_destroy_pass(m_pass);
+    sg_destroy_image(m_depth);
+    sg_destroy_image(m_color);
+}
+
+void
+PixelTarget::begin(const sg_pass_action& action)
+{
+    sg_begin_pass(m_pass, &action);
+}
+
+void
+PixelTarget::end()
+{
+    sg_end_pass();
+}
+
+int
+PixelTarget::scale(int width, int height) const
+{
+    return std::max(1, std::min(width / m_size.x, height / m_size.y));
+}
+
+void
+PixelTarget::blit(int width, int height)
+{
+    // everything outside the scaled target is left black
+    sg_pass_action pass = {
+        .colors[0].action = SG_ACTION_CLEAR,
+        .colors[0].value  = { 0.0f, 0.0f, 0.0f, 1.0f },
+    };
+    sg_begin_default_pass(&pass, width, height);
+
+    glm::ivec2 size = m_size * scale(width, height);
+    sg_apply_viewport((width - size.x) / 2, (height - size.y) / 2, size.x,
+        size.y, true);
+    sg_apply_pipeline(m_pipeline);
+    sg_bindings bind{
+        .vertex_buffers[0] = m_vb,
+        .fs_images[SLOT_tex] = m_color,
+    };
+    sg_apply_bindings(&bind);
+    sg_draw(0, 3, 1);
+    sg_end_pass();
+}
+
+} // namespace render
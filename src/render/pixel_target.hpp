@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+
+namespace render {
+
+/// offscreen render target at the game's native resolution
+///
+/// The scene is drawn into the target between begin() and end(), then
+/// blit() scales it up to the window by the largest whole factor that fits,
+/// with nearest-neighbour filtering, and letterboxes the rest.  Fill cost
+/// stays that of the native resolution whatever the window size, and every
+/// game pixel covers the same number of screen pixels.
+class PixelTarget
+{
+public:
+    PixelTarget(glm::ivec2 size);
+    PixelTarget(const PixelTarget&) = delete;
+    ~PixelTarget();
+
+    /// start the offscreen pass
+    void begin(const sg_pass_action&);
+    void end();
+
+    /// draw the target to the default framebuffer in a pass of its own
+    void blit(int width, int height);
+
+    inline glm::ivec2 size() const { return m_size; }
+
+    /// largest whole multiple of the target size that fits the window
+    int scale(int width, int height) const;
+
+private:
+    glm::ivec2 m_size;
+    sg_image m_color;
+    sg_image m_depth;
+    sg_pass m_pass;
+    sg_shader m_shader;
+    sg_pipeline m_pipeline;
+    sg_buffer m_vb;
+};
+
+} // namespace render
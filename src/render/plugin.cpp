@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <chipmunk/chipmunk.h>
 #include <entt/entt.hpp>
+#include <fmt/format.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
 #include <sokol_app.h>
@@ -17,21 +23,47 @@
 #include "../physics/shape.hpp"
 #include "../render.hpp"
 #include "../system.hpp"
+#include "../thread_pool.hpp"
+#include "../transient.hpp"
 #include "chipmunk/chipmunk_types.h"
-#include "entt/core/algorithm.hpp"
+#include "capture.hpp"
+#include "frame_stats.hpp"
+#include "grid_renderer.hpp"
+#include "line_layer.hpp"
 #include "line_renderer.hpp"
+#include "pixel_target.hpp"
 #include "plugin.hpp"
 #include "quad_renderer.hpp"
+#include "render_queue.hpp"
+#include "retained_sprites.hpp"
+#include "snapshot.hpp"
+#include "spatial_grid.hpp"
+#include "static_layer.hpp"
 
 namespace render {
 
-plugin::plugin(entt::registry&)
+/// ImGui::Checkbox() for a flag read by other threads
+static void
+checkbox(const char* label, std::atomic<bool>& flag)
+{
+    bool value = flag;
+    if (ImGui::Checkbox(label, &value)) {
+        flag = value;
+    }
+}
+
+plugin::plugin(entt::registry& ecs)
 {
     log_debug("load render plugin");
+    ecs.ctx().emplace<SpriteFrames>();
+
     // setup sokol-gfx, sokol-time and sokol-imgui
     sg_desc desc = {};
     desc.context = sapp_sgcontext();
     sg_setup(&desc);
+
+    // install the trace hooks before sokol_imgui installs its own
+    m_frame_stats = std::make_unique<FrameStats>();
 }
 
 plugin::~plugin()
@@ -98,6 +130,35 @@ plugin::reset_camera(entt::registry& ecs)
 {
     auto& body = ecs.get<physics::Body>(m_camera);
     cpBodySetPosition(body, { 8, 8 });
+    physics::mark_moved(ecs, m_camera);
+}
+
+void
+plugin::on_static_change(entt::registry&, entt::entity)
+{
+    m_bake_static = true;
+}
+
+void
+plugin::on_sprite_destroy(entt::registry&, entt::entity e)
+{
+    m_sprite_grid->remove(e);
+    if (m_retained != nullptr) {
+        m_retained->remove(e);
+    }
+}
+
+void
+plugin::retain_sprite(entt::registry& ecs, entt::entity e)
+{
+    const auto& frames = ecs.ctx().get<SpriteFrames>();
+    auto [tsl, sprite] = ecs.get<const Translate, const Sprite>(e);
+    auto& frame = frames[sprite.frame];
+    if (!m_retaining || !frame.opaque || ecs.all_of<Static>(e)) {
+        m_retained->remove(e);
+        return;
+    }
+    m_retained->update(e, { tsl.v, sprite.res, frame.layer, frame.uv, tsl.z });
 }
 
 void
@@ -111,86 +172,253 @@ plugin::init(entt::registry& ecs)
         editor.add<Sprite>("render::Sprite");
     }
 
+    // main_async handlers must not touch the registry, so the frames are
+    // looked up once here
+    m_frames = &ecs.ctx().get<SpriteFrames>();
+
     // create our renderers; we do this late to allow sokol_imgui to get it's
     // hooks in to be able to see any resources we allocate
     m_quad_renderer = std::make_unique<QuadRenderer>(40000, 60000);
     m_line_renderer = std::make_unique<LineRenderer>(40000, 60000);
+    m_grid_renderer = std::make_unique<GridRenderer>();
+    m_target = std::make_unique<PixelTarget>(glm::ivec2{
+        static_cast<int>(RESOLUTION.x), static_cast<int>(RESOLUTION.y) });
+    m_debug_lines = std::make_unique<LineLayer>();
+    m_snapshots = std::make_unique<SnapshotBuffer>();
+    m_static_layer = std::make_unique<StaticLayer>(*m_quad_renderer);
+    m_retained = std::make_unique<RetainedSprites>();
+    m_sprite_grid = std::make_unique<SpatialGrid>(4 * TILE_SIZE.x);
+
+    // draw_sprites runs alongside the simulation, which uses the thread_pool
+    // in the registry context, so it gets a pool of its own; the two split
+    // the cores between them, see init() in main.cpp
+    m_pool = std::make_unique<thread_pool>(
+        std::max(1u, std::thread::hardware_concurrency() / 2));
 
     // create the camera
     m_camera = create_camera(ecs);
 
+    // entities that get a Translate need to be synced at least once,
+    // and added to the sprite grid
+    ecs.on_construct<Translate>().connect<&physics::mark_moved>();
+    ecs.on_construct<Sprite>().connect<&physics::mark_moved>();
+    ecs.on_update<Sprite>().connect<&physics::mark_moved>();
+    ecs.on_destroy<Translate>().connect<&plugin::on_sprite_destroy>(*this);
+    ecs.on_destroy<Sprite>().connect<&plugin::on_sprite_destroy>(*this);
+
+    // adding or removing a static sprite requires the static layer be rebuilt
+    ecs.on_construct<Static>().connect<&plugin::on_static_change>(*this);
+    ecs.on_destroy<Static>().connect<&plugin::on_static_change>(*this);
+    ecs.on_construct<Static>().connect<&physics::mark_moved>();
+    ecs.on_destroy<Static>().connect<&physics::mark_moved>();
+
     // setup our systems
     entt::entity entity = ecs.create();
     ecs.emplace<System>(entity,
-        System::Config<Translate, const Sprite, const physics::Body>{
+        System::Config<>{
             .name  = "render::update_translate",
             .stage = System::Stage::draw - 10,
             .handler =
-                [](auto&, auto& view, float) {
-                    for (auto&& [e, tr, sprite, body] : view.each()) {
-                        cpVect pos = body.pos();
-                        tr.v.x = pos.x - sprite.res.x/2;
-                        tr.v.y = pos.y - sprite.res.y/2;
+                [this](auto& ecs, float) {
+                    auto statics = ecs.template view<Static>();
+                    auto sprites = ecs.template view<Translate, const Sprite>();
+                    auto bodies = ecs.template view<const physics::Body>();
+                    auto& moved = ecs.ctx().template get<physics::Moved>();
+
+                    // only opaque sprites drawn by the opaque pass can be
+                    // retained; start over whenever that changes
+                    const auto& frames =
+                        ecs.ctx().template get<SpriteFrames>();
+                    bool retain = m_retain_opaque && m_opaque_pass
+                        && m_texture_array
+                        && frames.layers().id != SG_INVALID_ID;
+                    if (retain != m_retaining) {
+                        m_retaining = retain;
+                        m_retained->clear();
+                        for (auto e : sprites) {
+                            retain_sprite(ecs, e);
+                        }
+                    }
+
+                    for (auto e : moved.entities) {
+                        if (!sprites.contains(e)) {
+                            continue;
+                        }
+                        auto [tr, sprite] = sprites.get(e);
+                        if (bodies.contains(e)) {
+                            cpVect pos =
+                                bodies.template get<const physics::Body>(e)
+                                    .pos();
+                            tr.v.x = pos.x - sprite.res.x/2;
+                            tr.v.y = pos.y - sprite.res.y/2;
+                        }
+                        retain_sprite(ecs, e);
+
+                        // static sprites are drawn by the static layer
+                        if (statics.contains(e)) {
+                            m_bake_static = true;
+                            m_sprite_grid->remove(e);
+                        } else {
+                            m_sprite_grid->update(e, tr.v, tr.v + sprite.res);
+                        }
                     }
                 },
         });
     ecs.emplace<HumanDescription>(entity, "system: update render::Translate",
-        "copies position updates from physics::Body into"
-        " render::Translate");
+        "copies position updates from moved physics::Body into"
+        " render::Translate, and updates the sprite grid & the slots of"
+        " retained sprites");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
-        System::Config<const Camera, const physics::Collision>{
+        System::Config<const Camera>{
             .name  = "render::move_camera",
             .stage = System::Stage::draw - 10,
             .handler =
                 [this](auto& ecs, auto& view, float) {
-                    for (auto&& [e, col] : view.each()) {
-                        move_camera(ecs, e, col.normal);
+                    auto& collisions = transient<physics::Collision>(ecs);
+                    for (auto e : view) {
+                        if (auto* col = collisions.find(e)) {
+                            move_camera(ecs, e, col->normal);
+                        }
                     }
                 },
         });
     ecs.emplace<HumanDescription>(entity, "system: move_camera",
         "Moves camera when player collides with the screen boundary");
 
-    // XXX does not need to happen every frame, only when Translate is updated,
-    // or added
+    // always run so step-mode still shows the current state of the registry
+    entity = ecs.create();
+    ecs.emplace<System>(entity,
+        System::Config<const Translate, const Sprite>{
+            .name  = "render::publish_snapshot",
+            .always_run = true,
+            .stage = System::Stage::draw - 1,
+            .handler =
+                [this](auto& ecs, auto& view, float) {
+                    auto& snap = m_snapshots->back();
+                    snap.camera =
+                        ecs.template get<physics::Body>(m_camera).pos();
+
+                    // only the sprites on screen
+                    glm::vec2 min{ snap.camera.x, snap.camera.y };
+                    glm::vec2 max{ min.x + RESOLUTION.x, min.y + RESOLUTION.y };
+                    m_visible.clear();
+                    m_sprite_grid->query(min, max, m_visible);
+
+                    // order them by z, then y; opaque sprites drawn from
+                    // the texture array are ordered by the depth test
+                    // instead, so they skip the sort
+                    const auto& frames =
+                        ecs.ctx().template get<SpriteFrames>();
+                    bool opaque_pass = m_opaque_pass && m_texture_array
+                        && frames.layers().id != SG_INVALID_ID;
+                    snap.opaque.clear();
+                    m_queue.clear();
+                    for (uint32_t i = 0; i < m_visible.size(); i++) {
+                        if (m_retained->contains(m_visible[i])) {
+                            continue;
+                        }
+                        auto [tsl, sprite] = view.get(m_visible[i]);
+                        auto& frame = frames[sprite.frame];
+                        if (opaque_pass && frame.opaque) {
+                            snap.opaque.emplace_back(tsl, sprite);
+                            continue;
+                        }
+                        m_queue.push(
+                            RenderQueue::key(tsl.z, tsl.v.y, frame.img.id), i);
+                    }
+                    m_queue.sort();
+
+                    snap.sprites.clear();
+                    for (auto& item : m_queue) {
+                        auto [tsl, sprite] = view.get(m_visible[item.payload]);
+                        snap.sprites.emplace_back(tsl, sprite);
+                    }
+                    m_snapshots->publish();
+                    m_retained->publish();
+                },
+        });
+    ecs.emplace<HumanDescription>(entity, "system: publish render snapshot",
+        "copies the camera position, and render::Translate &"
+        " render::Sprite of the sprites on screen in draw order, into a"
+        " snapshot for the draw & render stages; opaque sprites are left"
+        " unsorted, and retained sprites out");
+
+    // sokol resources can only be created from the main thread
     entity = ecs.create();
     ecs.emplace<System>(entity,
         System::Config<>{
-            .name  = "render::insert_sort_sprites",
+            .name  = "render::bake_static",
+            .always_run = true,
             .stage = System::Stage::draw - 1,
+            .thread = System::Thread::main_sync,
             .handler =
-                [](auto& ecs, float) {
-                    entt::insertion_sort algo;
-                    ecs.template sort<Translate>(
-                        [](const auto& lhs, const auto& rhs) {
-                            return lhs.z == rhs.z ? lhs.v.y < rhs.v.y
-                                                  : lhs.z < rhs.z;
-                        },
-                        algo);
+                [this](auto& ecs, float) {
+                    if (!m_bake_static) {
+                        return;
+                    }
+                    m_bake_static = false;
+                    m_static_layer->bake(ecs);
                 },
         });
-    ecs.emplace<HumanDescription>(entity, "system: insert sort sprites",
-        "insert sort sprites using standard sort");
+    ecs.emplace<HumanDescription>(entity, "system: bake static sprites",
+        "rebuilds the GPU buffers for render::Static sprites when any of"
+        " them change");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
-        System::Config<const Translate, const Sprite>{
+        System::Config<>{
             .name  = "render::draw_sprites",
             .always_run = true,
             .stage = System::Stage::draw,
+            .thread = System::Thread::main_async,
             .handler =
-                [this](auto&, auto& view, float) {
-                    for (auto&& [e, tsl, sprite] : view.each()) {
-                        m_quad_renderer->draw_rect(
-                            tsl, sprite.res, sprite.img, sprite.crop);
+                [this](auto&, float) {
+                    const auto& snap = m_snapshots->acquire();
+                    const auto& frames = *m_frames;
+                    m_retained->apply();
+
+                    // sprites are encoded relative to the camera, which is
+                    // within 16 bits of everything on screen
+                    m_quad_renderer->set_origin({
+                        static_cast<int>(std::floor(snap.camera.x)),
+                        static_cast<int>(std::floor(snap.camera.y)) });
+
+                    // the texture array needs no texture slots, so any
+                    // number of sheets share a single draw call; the opaque
+                    // pass is only split out when drawing from it
+                    if (!snap.opaque.empty() || (m_texture_array
+                            && frames.layers().id != SG_INVALID_ID)) {
+                        auto layer_quad = [&frames](const auto& s) {
+                            auto& [tsl, sprite] = s;
+                            auto& frame = frames[sprite.frame];
+                            return QuadRenderer::LayerQuad{ tsl.v,
+                                sprite.res, frame.layer, frame.uv, tsl.z };
+                        };
+                        m_quad_renderer->set_layers(frames.layers());
+                        m_quad_renderer->draw_opaque_layers(*m_pool,
+                            snap.opaque.size(), [&](size_t i) {
+                                return layer_quad(snap.opaque[i]);
+                            });
+                        m_quad_renderer->draw_layers(*m_pool,
+                            snap.sprites.size(), [&](size_t i) {
+                                return layer_quad(snap.sprites[i]);
+                            });
+                        return;
                     }
+                    m_quad_renderer->draw_sprites(*m_pool, snap.sprites.size(),
+                        [&snap, &frames](size_t i) {
+                            auto& [tsl, sprite] = snap.sprites[i];
+                            auto& frame = frames[sprite.frame];
+                            return QuadRenderer::Quad{ tsl.v, sprite.res,
+                                frame.img, frame.uv, tsl.z };
+                        });
                 },
         });
     ecs.emplace<HumanDescription>(entity, "system: draw render::Sprite",
         "performs draw calls for entities with render::Translate and"
-        " render::Sprite");
+        " render::Sprite, other than render::Static");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
@@ -198,65 +426,111 @@ plugin::init(entt::registry& ecs)
             .name  = "render::draw_grid",
             .always_run = true,
             .stage = System::Stage::draw_debug - 1,
+            .thread = System::Thread::main_async,
             .handler =
-                [this](auto& ecs, float) {
-                    auto &body = ecs.template get<physics::Body>(m_camera);
-                    cpVect pos = body.pos();
-                    cpVect tl  = pos - (pos % TILE_SIZE) + TILE_SIZE/2;
-                    cpVect br  = pos + RESOLUTION;
-
-                    for (int y = tl.y; y < br.y; y += TILE_SIZE.y) {
-                        draw_line({ pos.x, y }, { br.x, y },
-                            { 0x30, 0x60, 0x60, 0x80 });
-                    }
-                    for (int x = tl.x; x < br.x; x += TILE_SIZE.x) {
-                        draw_line({ x, pos.y }, { x, br.y },
-                            { 0x30, 0x60, 0x60, 0x80 });
-                    }
-                },
+                [this](auto&, float) { m_draw_grid = true; },
         });
     ecs.emplace<HumanDescription>(entity, "system: draw grid",
-            "draw tile grid on screen");
+            "draw tile grid on screen, with a single fullscreen shader pass");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
         System::Config<>{
             .name  = "render::render",
-            .stage = System::Stage::render,
             .always_run = true,
+            .stage = System::Stage::render,
+            .thread = System::Thread::main_async,
             .handler =
-                [this](auto& ecs, float) {
-                    // get the projection matrix from the camera physics body
-                    auto& body     = ecs.template get<physics::Body>(m_camera);
-                    cpVect pos     = cpBodyGetPosition(body);
+                [this](auto&, float) {
+                    // get the projection matrix from the snapshot camera;
+                    // quads use a camera-relative one, see QuadRenderer::View
+                    cpVect pos     = m_snapshots->current().camera;
                     glm::mat4 proj = glm::ortho(pos.x, pos.x + RESOLUTION.x,
                         pos.y, pos.y + RESOLUTION.y, -1.0f, 1.0f);
+                    QuadRenderer::View view{
+                        .proj = glm::ortho(0.0f, (float)RESOLUTION.x, 0.0f,
+                            (float)RESOLUTION.y, -1.0f, 1.0f),
+                        .camera = { pos.x, pos.y },
+                    };
 
-                    // start a pass
+                    // start a pass, at native resolution when pixel
+                    // perfect, and at the window's otherwise
+                    const sg_color clear = {0.0f, 0.5f, 0.7f, 1.0f};
                     sg_pass_action pass = {
                         .colors[0].action = SG_ACTION_CLEAR,
-                        .colors[0].value  = {0.0f, 0.5f, 0.7f, 1.0f},
+                        .colors[0].value  = clear,
                     };
-                    sg_begin_default_pass(&pass, sapp_width(), sapp_height());
+                    int width = sapp_width(), height = sapp_height();
+                    if (m_pixel_perfect) {
+                        m_target->begin(pass);
+                        width = m_target->size().x;
+                        height = m_target->size().y;
+                    } else {
+                        sg_begin_default_pass(&pass, width, height);
+                    }
 
-                    m_quad_renderer->render(proj);
+                    m_static_layer->render(view);
+                    m_retained->render(*m_quad_renderer, view);
+                    m_quad_renderer->render(view);
+                    if (m_draw_grid) {
+                        m_grid_renderer->render(view.camera,
+                            { RESOLUTION.x, RESOLUTION.y },
+                            { TILE_SIZE.x, TILE_SIZE.y },
+                            { TILE_SIZE.x / 2, TILE_SIZE.y / 2 },
+                            { 0x30, 0x60, 0x60, 0x80 });
+                        m_draw_grid = false;
+                    }
+                    if (m_show_debug_lines) {
+                        m_debug_lines->render(
+                            *m_line_renderer, proj, view.camera);
+                        m_show_debug_lines = false;
+                    }
                     m_line_renderer->render(proj);
 
-                    sg_end_pass();
+                    if (m_pixel_perfect) {
+                        m_target->end();
+                        m_target->blit(sapp_width(), sapp_height());
+                    } else {
+                        sg_end_pass();
+                    }
+
+                    if (m_capture != nullptr) {
+                        capture::Frame frame{ .header = {
+                            .clear = { clear.r, clear.g, clear.b, clear.a },
+                            .width = width,
+                            .height = height,
+                            .quad_proj = view.proj,
+                            .camera = view.camera,
+                            .line_proj = proj,
+                        } };
+                        m_quad_renderer->capture(frame);
+                        m_retained->capture(*m_quad_renderer, frame);
+                        m_line_renderer->capture(frame);
+                        if (!m_capture->write(frame)
+                                || --m_capture_frames == 0) {
+                            log_info("render capture finished");
+                            m_capture.reset();
+                        }
+                    }
                 },
         });
     ecs.emplace<HumanDescription>(entity, "system: render",
-        "renders all draw calls to the frame buffer");
+        "renders all draw calls to the frame buffer, or to a native resolution"
+        " target that is then scaled up to it");
 
     entity = ecs.create();
     ecs.emplace<System>(entity,
         System::Config<>{
             .name  = "render::flush_frame",
-            .stage = System::Stage::flush_frame,
             .always_run = true,
+            .stage = System::Stage::flush_frame,
+            .thread = System::Thread::main_async,
             .handler =
                 [this](auto&, float) {
                     sg_commit();
+                    if (m_stats_csv != nullptr) {
+                        write_stats();
+                    }
                     m_quad_renderer->clear();
                     m_line_renderer->clear();
                 },
@@ -270,9 +544,74 @@ void
 plugin::cleanup(entt::registry&)
 {
     log_debug("cleanup graphics");
+    m_pool.reset();
+    m_static_layer.reset();
+    m_retained.reset();
     m_quad_renderer.reset();
+    m_debug_lines.reset();
+    m_grid_renderer.reset();
+    m_target.reset();
     m_line_renderer.reset();
     m_blank.reset();
+    if (m_stats_csv != nullptr) {
+        std::fclose(m_stats_csv);
+        m_stats_csv = nullptr;
+    }
+    m_capture.reset();
+}
+
+bool
+plugin::record_stats(const char* path)
+{
+    m_stats_csv = std::fopen(path, "w");
+    if (m_stats_csv == nullptr) {
+        log_errno("failed to open render stats file {}", path);
+        return false;
+    }
+    log_info("recording render stats to {}", path);
+
+    fmt::print(m_stats_csv, "frame,passes,pipelines,bindings,uniforms,draws,"
+        "vertices,indices,instances,uploads,vertex_bytes,index_bytes,"
+        "uniform_bytes");
+    for (auto name : { "quad_vertices", "quad_indices", "quad_instances",
+             "quad_layers", "quad_opaque", "line_vertices",
+             "line_indices" }) {
+        fmt::print(m_stats_csv, ",{0}_used,{0}_capacity", name);
+    }
+    fmt::print(m_stats_csv, "\n");
+    return true;
+}
+
+bool
+plugin::capture(const char* path, size_t frames)
+{
+    auto writer = std::make_unique<capture::Writer>();
+    if (!writer->open(path)) {
+        return false;
+    }
+    log_info("capturing {} frames of render submissions to {}", frames, path);
+    m_capture = std::move(writer);
+    m_capture_frames = frames;
+    return true;
+}
+
+void
+plugin::write_stats()
+{
+    const auto& c = m_frame_stats->last();
+    fmt::print(m_stats_csv, "{},{},{},{},{},{},{},{},{},{},{},{},{}",
+        c.frame, c.passes, c.pipelines, c.bindings, c.uniforms, c.draws,
+        c.vertices, c.indices, c.instances, c.uploads, c.vertex_bytes,
+        c.index_bytes, c.uniform_bytes);
+
+    const auto& quads = m_quad_renderer->stats();
+    auto lines = m_line_renderer->stats();
+    for (const auto& b : { quads.vertices, quads.indices,
+             quads.instance_buffer, quads.layer_buffer, quads.opaque_buffer,
+             lines.vertices, lines.indices }) {
+        fmt::print(m_stats_csv, ",{},{}", b.used, b.capacity);
+    }
+    fmt::print(m_stats_csv, "\n");
 }
 
 void
@@ -286,6 +625,91 @@ plugin::draw_line(vec2 a, vec2 b, rgba color)
 {
     m_line_renderer->draw_seg(a, b, color);
 }
+
+void
+plugin::show_stats()
+{
+    const auto& c = m_frame_stats->last();
+    ImGui::Text("frame %llu: %u passes, %u draws",
+        (unsigned long long)c.frame, c.passes, c.draws);
+    ImGui::Text("applied: %u pipelines, %u bindings, %u uniforms",
+        c.pipelines, c.bindings, c.uniforms);
+    ImGui::Text("drawn: %llu vertices, %llu indices, %llu instances",
+        (unsigned long long)c.vertices, (unsigned long long)c.indices,
+        (unsigned long long)c.instances);
+    ImGui::Text("uploaded: %llu vertex, %llu index, %llu uniform bytes"
+        " in %u calls", (unsigned long long)c.vertex_bytes,
+        (unsigned long long)c.index_bytes, (unsigned long long)c.uniform_bytes,
+        c.uploads);
+    if (m_capture != nullptr) {
+        ImGui::Text("capturing, %zu frames left", m_capture_frames);
+    } else if (ImGui::Button("capture 60 frames")) {
+        capture("render.rcap");
+    }
+    checkbox("texture array", m_texture_array);
+    ImGui::SameLine();
+    checkbox("opaque depth pass", m_opaque_pass);
+    ImGui::SameLine();
+    checkbox("retain opaque sprites", m_retain_opaque);
+    ImGui::Checkbox("pixel perfect", &m_pixel_perfect);
+    if (m_pixel_perfect) {
+        ImGui::SameLine();
+        ImGui::Text("%dx%d, scaled %dx", m_target->size().x,
+            m_target->size().y, m_target->scale(sapp_width(), sapp_height()));
+    }
+    ImGui::Separator();
+
+    const auto& stats = m_quad_renderer->stats();
+    ImGui::Text("quads %zu, instances %zu, layers %zu, opaque %zu,"
+        " batches %zu", stats.quads, stats.instances, stats.layers,
+        stats.opaque, stats.batches);
+    for (size_t i = 0; i < stats.batch_quads.size(); i++) {
+        ImGui::BulletText("batch %zu: %zu", i, stats.batch_quads[i]);
+    }
+    ImGui::Text("static chunks %zu, debug line chunks %zu",
+        m_static_layer->chunks(), m_debug_lines->chunks());
+    ImGui::Text("sprites visible %zu of %zu", m_visible.size(),
+        m_sprite_grid->size());
+    const auto& retained = m_retained->stats();
+    ImGui::Text("retained slots %zu in %zu pages of %zu chunks, %zu written,"
+        " %zu pages uploaded, %zu drawn", retained.slots, retained.pages,
+        retained.chunks, retained.writes, retained.uploaded, retained.drawn);
+
+    auto lines = m_line_renderer->stats();
+    const std::pair<const char*, const StreamStats&> buffers[] = {
+        { "quad vertices", stats.vertices },
+        { "quad indices", stats.indices },
+        { "quad instances", stats.instance_buffer },
+        { "quad layers", stats.layer_buffer },
+        { "quad opaque", stats.opaque_buffer },
+        { "line vertices", lines.vertices },
+        { "line indices", lines.indices },
+    };
+    if (ImGui::BeginTable("stream_buffers", 5,
+            ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("buffer", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("used", ImGuiTableColumnFlags_WidthFixed, 50);
+        ImGui::TableSetupColumn("max", ImGuiTableColumnFlags_WidthFixed, 50);
+        ImGui::TableSetupColumn(
+            "capacity", ImGuiTableColumnFlags_WidthFixed, 60);
+        ImGui::TableSetupColumn("grown", ImGuiTableColumnFlags_WidthFixed, 40);
+        ImGui::TableHeadersRow();
+        for (auto& [name, s] : buffers) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", s.used);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", s.high_water);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", s.capacity);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", s.grown);
+        }
+        ImGui::EndTable();
+    }
+}
 } // namespace render
 
 namespace entity_editor {
@@ -295,6 +719,7 @@ void
 draw_component<render::Translate>(entt::registry& ecs, entt::entity e)
 {
     auto& obj = ecs.get<render::Translate>(e);
+    auto orig = obj;
     ImGui::PushID(&obj);
     if (ImGui::BeginTable("render::translate", 2, 0)) {
         ImGui::TableSetupColumn(
@@ -317,6 +742,11 @@ draw_component<render::Translate>(entt::registry& ecs, entt::entity e)
         ImGui::EndTable();
     }
     ImGui::PopID();
+
+    // Translate changes move the sprite in the grid, or the static layer
+    if (obj.v != orig.v || obj.z != orig.z) {
+        physics::mark_moved(ecs, e);
+    }
 }
 
 } // namespace render
@@ -1,15 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <cstdio>
+#include <vector>
 #include <entt/fwd.hpp>
 #include <entt/entity/entity.hpp>
 #include <chipmunk/chipmunk_types.h>
 #include "../image.hpp"
+#include "render_queue.hpp"
 #include "rgba.hpp"
 
+class thread_pool;
+
 namespace render {
 
 class QuadRenderer;
 class LineRenderer;
+class LineLayer;
+class GridRenderer;
+class PixelTarget;
+class FrameStats;
+class SnapshotBuffer;
+class StaticLayer;
+class RetainedSprites;
+class SpatialGrid;
+class SpriteFrames;
+
+namespace capture { class Writer; }
 
 using vec2 = glm::vec2;
 
@@ -28,15 +45,73 @@ public:
     void draw_rect(vec2 pos, vec2 size, rgba color);
     void draw_line(vec2 a, vec2 b, rgba color);
 
+    /// lines drawn every frame until the layer is rebuilt, for debug shapes
+    /// that rarely change
+    inline LineLayer& debug_lines() { return *m_debug_lines; }
+
+    /// render debug_lines() this frame; called every frame they should be
+    /// on screen, so they go away with whatever draws them
+    inline void show_debug_lines() { m_show_debug_lines = true; }
+
+    /// the renderer & pool render::draw_sprites uses, for drawing alongside
+    /// it from other main_async systems after it has set the origin
+    inline QuadRenderer& quads() { return *m_quad_renderer; }
+    inline thread_pool& pool() { return *m_pool; }
+
+    /// check if sprites are drawn from the texture array, when there is one
+    inline bool texture_array() const { return m_texture_array; }
+
+    /// show renderer statistics in the current ImGui window
+    void show_stats();
+
+    /// write a CSV row of FrameStats & buffer utilization to `path` for
+    /// every frame from now on; for headless & CI runs
+    bool record_stats(const char* path);
+
+    /// write the quads & lines submitted over the next `frames` frames to a
+    /// capture file, for bench/render_replay
+    bool capture(const char* path, size_t frames = 60);
+
 private:
     entt::entity create_camera(entt::registry&);
     void set_camera_collision_handler(entt::registry&);
     void move_camera(entt::registry&, entt::entity, cpVect);
+    void on_static_change(entt::registry&, entt::entity);
+    void on_sprite_destroy(entt::registry&, entt::entity);
+    void retain_sprite(entt::registry&, entt::entity);
+    void write_stats();
 
     Image m_blank{};
+    std::unique_ptr<FrameStats> m_frame_stats{nullptr};
     std::unique_ptr<QuadRenderer> m_quad_renderer{nullptr};
     std::unique_ptr<LineRenderer> m_line_renderer{nullptr};
+    std::unique_ptr<GridRenderer> m_grid_renderer{nullptr};
+    std::unique_ptr<PixelTarget> m_target{nullptr};
+    std::unique_ptr<LineLayer> m_debug_lines{nullptr};
+    std::unique_ptr<SnapshotBuffer> m_snapshots{nullptr};
+    std::unique_ptr<StaticLayer> m_static_layer{nullptr};
+    std::unique_ptr<RetainedSprites> m_retained{nullptr};
+    std::unique_ptr<SpatialGrid> m_sprite_grid{nullptr};
+    std::unique_ptr<thread_pool> m_pool{nullptr};
+    const SpriteFrames* m_frames{nullptr};   // cached for main_async
+    std::vector<entt::entity> m_visible{};  // reused by publish_snapshot
+    RenderQueue m_queue{};
     entt::entity m_camera{entt::null};
+    bool m_bake_static{true};   // set when a render::Static sprite changed
+    bool m_draw_grid{false};    // set by render::draw_grid for this frame
+    bool m_show_debug_lines{false}; // set by show_debug_lines() for this frame
+    bool m_pixel_perfect{true}; // render into m_target, then scale it up
+    bool m_retaining{false};    // m_retain_opaque as last applied by the sim
+
+    // toggled from ImGui, read by the simulation: draw sprites from
+    // SpriteFrames::layers(), opaque ones unsorted & depth tested, and keep
+    // those in m_retained
+    std::atomic<bool> m_texture_array{true};
+    std::atomic<bool> m_opaque_pass{true};
+    std::atomic<bool> m_retain_opaque{true};
+    std::FILE* m_stats_csv{nullptr};
+    std::unique_ptr<capture::Writer> m_capture{nullptr};
+    size_t m_capture_frames{0};     // frames left to capture
 };
 
 } // namespace render
@@ -0,0 +1,242 @@
+#include "quad_kernel.hpp"
+
+#ifdef QUAD_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+namespace render::quad_kernel {
+
+/// write one quad from its already relative corners; positions truncate to
+/// 16 bits the same way draw_rect()'s glm conversion does
+static inline void
+write_quad(Vertex* v, float slot, int32_t x0, int32_t y0, int32_t x1,
+    int32_t y1, float u0, float v0, float u1, float v1)
+{
+    const QuadRenderer::rgba white{ 255, 255, 255, 255 };
+    auto pos = [](int32_t x, int32_t y) {
+        return glm::vec<2, int16_t>{ static_cast<int16_t>(x),
+            static_cast<int16_t>(y) };
+    };
+    v[0] = { pos(x0, y0), slot, { u0, v0 }, white };
+    v[1] = { pos(x1, y0), slot, { u1, v0 }, white };
+    v[2] = { pos(x1, y1), slot, { u1, v1 }, white };
+    v[3] = { pos(x0, y1), slot, { u0, v1 }, white };
+}
+
+/// indices of quad q, with the same winding as draw_rect()
+static inline void
+write_indices(uint16_t* i, uint16_t base)
+{
+    i[0] = base;
+    i[1] = base + 1;
+    i[2] = base + 2;
+    i[3] = base;
+    i[4] = base + 3;
+    i[5] = base + 2;
+}
+
+void
+expand_scalar(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices)
+{
+    for (size_t q = 0; q < count; q++) {
+        glm::vec2 p = pos[q] - origin;
+        glm::vec2 s = p + size[q];
+        const glm::vec4& t = uv[q];
+        write_quad(&vertices[q * 4], slot, static_cast<int32_t>(p.x),
+            static_cast<int32_t>(p.y), static_cast<int32_t>(s.x),
+            static_cast<int32_t>(s.y), t.x, t.y, t.x + t.z, t.y + t.w);
+        write_indices(&indices[q * 6], base + q * 4);
+    }
+}
+
+#ifdef QUAD_KERNEL_X86
+
+// indices for eight consecutive quads starting at vertex 0; SSE2 uses the
+// first four quads
+alignas(32) static const uint16_t INDEX_PATTERN[48] = {
+     0,  1,  2,  0,  3,  2,   4,  5,  6,  4,  7,  6,
+     8,  9, 10,  8, 11, 10,  12, 13, 14, 12, 15, 14,
+    16, 17, 18, 16, 19, 18,  20, 21, 22, 20, 23, 22,
+    24, 25, 26, 24, 27, 26,  28, 29, 30, 28, 31, 30,
+};
+
+// The arithmetic is done a register of quads at a time, into small arrays
+// that the vertices are then written from; vertices are 20 bytes, so they
+// can't be built in registers without a shuffle per field.
+
+void
+expand_sse2(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices)
+{
+    const __m128 ox = _mm_set1_ps(origin.x);
+    const __m128 oy = _mm_set1_ps(origin.y);
+    const __m128i* pattern = reinterpret_cast<const __m128i*>(INDEX_PATTERN);
+
+    size_t q = 0;
+    for (; q + 4 <= count; q += 4) {
+        // split the vec2s into x & y
+        __m128 p01 = _mm_loadu_ps(&pos[q].x);
+        __m128 p23 = _mm_loadu_ps(&pos[q + 2].x);
+        __m128 s01 = _mm_loadu_ps(&size[q].x);
+        __m128 s23 = _mm_loadu_ps(&size[q + 2].x);
+        __m128 x = _mm_sub_ps(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0)),
+            ox);
+        __m128 y = _mm_sub_ps(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1)),
+            oy);
+        __m128 w = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 h = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(3, 1, 3, 1));
+
+        // and the vec4s into u, v, width & height
+        __m128 u0 = _mm_loadu_ps(&uv[q].x);
+        __m128 v0 = _mm_loadu_ps(&uv[q + 1].x);
+        __m128 uw = _mm_loadu_ps(&uv[q + 2].x);
+        __m128 vh = _mm_loadu_ps(&uv[q + 3].x);
+        _MM_TRANSPOSE4_PS(u0, v0, uw, vh);
+
+        alignas(16) int32_t x0[4], y0[4], x1[4], y1[4];
+        alignas(16) float tu0[4], tv0[4], tu1[4], tv1[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_cvttps_epi32(x));
+        _mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_cvttps_epi32(y));
+        _mm_store_si128(reinterpret_cast<__m128i*>(x1),
+            _mm_cvttps_epi32(_mm_add_ps(x, w)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(y1),
+            _mm_cvttps_epi32(_mm_add_ps(y, h)));
+        _mm_store_ps(tu0, u0);
+        _mm_store_ps(tv0, v0);
+        _mm_store_ps(tu1, _mm_add_ps(u0, uw));
+        _mm_store_ps(tv1, _mm_add_ps(v0, vh));
+        for (int k = 0; k < 4; k++) {
+            write_quad(&vertices[(q + k) * 4], slot, x0[k], y0[k], x1[k],
+                y1[k], tu0[k], tv0[k], tu1[k], tv1[k]);
+        }
+
+        __m128i b = _mm_set1_epi16(static_cast<int16_t>(base + q * 4));
+        __m128i* out = reinterpret_cast<__m128i*>(&indices[q * 6]);
+        for (int k = 0; k < 3; k++) {
+            _mm_storeu_si128(out + k,
+                _mm_add_epi16(_mm_load_si128(pattern + k), b));
+        }
+    }
+
+    expand_scalar(pos + q, size + q, uv + q, count - q, origin, slot,
+        base + q * 4, vertices + q * 4, indices + q * 6);
+}
+
+// deinterleave eight vec2s; the in-lane shuffle leaves the 64-bit pairs out
+// of order, which the permute fixes
+__attribute__((target("avx2"))) static inline void
+split8(const glm::vec2* v, __m256& a, __m256& b)
+{
+    __m256 lo = _mm256_loadu_ps(&v[0].x);
+    __m256 hi = _mm256_loadu_ps(&v[4].x);
+    a = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+        _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    b = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+        _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// load two vec4s into the low & high lanes of a register
+__attribute__((target("avx2"))) static inline __m256
+pair8(const glm::vec4& lo, const glm::vec4& hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&lo.x)),
+        _mm_loadu_ps(&hi.x), 1);
+}
+
+__attribute__((target("avx2"))) void
+expand_avx2(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices)
+{
+    const __m256 ox = _mm256_set1_ps(origin.x);
+    const __m256 oy = _mm256_set1_ps(origin.y);
+    const __m256i* pattern = reinterpret_cast<const __m256i*>(INDEX_PATTERN);
+
+    size_t q = 0;
+    for (; q + 8 <= count; q += 8) {
+        __m256 x, y, w, h;
+        split8(&pos[q], x, y);
+        split8(&size[q], w, h);
+        x = _mm256_sub_ps(x, ox);
+        y = _mm256_sub_ps(y, oy);
+
+        // transpose the vec4s within each lane; lane 0 holds quads 0-3
+        __m256 t0 = pair8(uv[q], uv[q + 4]);
+        __m256 t1 = pair8(uv[q + 1], uv[q + 5]);
+        __m256 t2 = pair8(uv[q + 2], uv[q + 6]);
+        __m256 t3 = pair8(uv[q + 3], uv[q + 7]);
+        __m256 a0 = _mm256_unpacklo_ps(t0, t1);
+        __m256 a1 = _mm256_unpackhi_ps(t0, t1);
+        __m256 a2 = _mm256_unpacklo_ps(t2, t3);
+        __m256 a3 = _mm256_unpackhi_ps(t2, t3);
+        __m256 u0 = _mm256_shuffle_ps(a0, a2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 v0 = _mm256_shuffle_ps(a0, a2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 uw = _mm256_shuffle_ps(a1, a3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 vh = _mm256_shuffle_ps(a1, a3, _MM_SHUFFLE(3, 2, 3, 2));
+
+        alignas(32) int32_t x0[8], y0[8], x1[8], y1[8];
+        alignas(32) float tu0[8], tv0[8], tu1[8], tv1[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(x0),
+            _mm256_cvttps_epi32(x));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(y0),
+            _mm256_cvttps_epi32(y));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(x1),
+            _mm256_cvttps_epi32(_mm256_add_ps(x, w)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(y1),
+            _mm256_cvttps_epi32(_mm256_add_ps(y, h)));
+        _mm256_store_ps(tu0, u0);
+        _mm256_store_ps(tv0, v0);
+        _mm256_store_ps(tu1, _mm256_add_ps(u0, uw));
+        _mm256_store_ps(tv1, _mm256_add_ps(v0, vh));
+        for (int k = 0; k < 8; k++) {
+            write_quad(&vertices[(q + k) * 4], slot, x0[k], y0[k], x1[k],
+                y1[k], tu0[k], tv0[k], tu1[k], tv1[k]);
+        }
+
+        __m256i b = _mm256_set1_epi16(static_cast<int16_t>(base + q * 4));
+        __m256i* out = reinterpret_cast<__m256i*>(&indices[q * 6]);
+        for (int k = 0; k < 3; k++) {
+            _mm256_storeu_si256(out + k,
+                _mm256_add_epi16(_mm256_load_si256(pattern + k), b));
+        }
+    }
+
+    expand_sse2(pos + q, size + q, uv + q, count - q, origin, slot,
+        base + q * 4, vertices + q * 4, indices + q * 6);
+}
+
+#endif // QUAD_KERNEL_X86
+
+Expand
+best()
+{
+#ifdef QUAD_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return expand_avx2;
+    }
+    return expand_sse2;
+#else
+    return expand_scalar;
+#endif
+}
+
+const char*
+name(Expand kernel)
+{
+#ifdef QUAD_KERNEL_X86
+    if (kernel == expand_avx2) {
+        return "avx2";
+    } else if (kernel == expand_sse2) {
+        return "sse2";
+    }
+#endif
+    return kernel == expand_scalar ? "scalar" : "unknown";
+}
+
+} // namespace render::quad_kernel
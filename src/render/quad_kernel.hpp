@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "quad_renderer.hpp"
+
+/// kernels expanding quads into vertices & indices for QuadRenderer
+///
+/// Each kernel writes the four vertices & six indices of `count` quads,
+/// exactly as QuadRenderer::draw_rect() would, straight into preallocated
+/// output.  Inputs are the structure-of-arrays spans of
+/// QuadRenderer::Rects; every quad uses the same texture slot, and its
+/// position must be within 16 bits of the origin.
+///
+/// The SSE2 & AVX2 kernels only vectorize on x86; elsewhere best() is the
+/// scalar kernel.
+namespace render::quad_kernel {
+
+using Vertex = QuadRenderer::Vertex;
+
+/// `base` is the index of the first vertex written, relative to its batch
+using Expand = void (*)(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices);
+
+void expand_scalar(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define QUAD_KERNEL_X86 1
+
+void expand_sse2(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices);
+
+void expand_avx2(const glm::vec2* pos, const glm::vec2* size,
+    const glm::vec4* uv, size_t count, glm::vec2 origin, float slot,
+    uint16_t base, Vertex* vertices, uint16_t* indices);
+#endif
+
+/// the fastest kernel this CPU supports, checked once at runtime
+Expand best();
+
+/// name of a kernel, for logs & benchmarks
+const char* name(Expand);
+
+} // namespace render::quad_kernel
@@ -1,15 +1,41 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include "quad_renderer.hpp"
+#include "capture.hpp"
+#include "quad_kernel.hpp"
 #include "shaders/quad.glsl.h"
+#include "shader_backend.hpp"
 #include "../log.hpp"
+#include "../thread_pool.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace render {
 
-QuadRenderer::QuadRenderer(size_t v_max, size_t i_max)
+/// position relative to an origin, which must fit in the 16-bit positions
+static inline glm::vec2
+relative(glm::vec2 pos, glm::ivec2 origin)
 {
-    assert(v_max < (2<<16) && "v_max exceeds uint16 index buffer");
+    glm::vec2 rel = pos - glm::vec2(origin);
+    assert(glm::all(glm::lessThanEqual(glm::abs(rel), glm::vec2(INT16_MAX)))
+        && "quad is out of range of the renderer origin");
+    return rel;
+}
 
+QuadRenderer::QuadRenderer(size_t v_max, size_t i_max)
+    : m_buf{
+        { SG_BUFFERTYPE_VERTEXBUFFER, v_max, "QuadRenderer::m_buf.v" },
+        { SG_BUFFERTYPE_INDEXBUFFER, i_max, "QuadRenderer::m_buf.i" },
+      },
+      // an instance replaces the four vertices of a quad
+      m_instances{
+          SG_BUFFERTYPE_VERTEXBUFFER, v_max / 4, "QuadRenderer::m_instances" },
+      m_layer_instances{ SG_BUFFERTYPE_VERTEXBUFFER, v_max / 4,
+          "QuadRenderer::m_layer_instances" },
+      m_opaque_instances{ SG_BUFFERTYPE_VERTEXBUFFER, v_max / 4,
+          "QuadRenderer::m_opaque_instances" }
+{
     /* create a pipeline object (default render state is fine) */
     m_pipeline_desc = {
         .label = "QuadRenderer",
@@ -29,23 +55,66 @@ QuadRenderer::QuadRenderer(size_t v_max, size_t i_max)
         },
     };
 
-    m_shader = sg_make_shader(quad_shader_desc(sg_query_backend()));
+    m_shader = sg_make_shader(quad_shader_desc(shader_backend()));
     m_pipeline_desc.shader = m_shader;
     m_pipeline = sg_make_pipeline(&m_pipeline_desc);
 
-    m_vb_desc = {
-        .type = SG_BUFFERTYPE_VERTEXBUFFER,
-        .usage = SG_USAGE_DYNAMIC,
-        .size = v_max * sizeof(Vertex),
+    // instanced pipeline; buffer 0 is the unit quad, buffer 1 the instances
+    sg_pipeline_desc instance_desc = {
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_instanced_v_corner] = {
+                    .buffer_index = 0, .format = SG_VERTEXFORMAT_FLOAT2 },
+                [ATTR_vs_instanced_i_pos] = {
+                    .buffer_index = 1, .format = SG_VERTEXFORMAT_SHORT2 },
+                [ATTR_vs_instanced_i_size] = {
+                    .buffer_index = 1, .format = SG_VERTEXFORMAT_SHORT2 },
+                [ATTR_vs_instanced_i_uv] = {
+                    .buffer_index = 1, .format = SG_VERTEXFORMAT_FLOAT4 },
+                [ATTR_vs_instanced_i_texture_z] = {
+                    .buffer_index = 1, .format = SG_VERTEXFORMAT_SHORT2 },
+                [ATTR_vs_instanced_i_color] = {
+                    .buffer_index = 1, .format = SG_VERTEXFORMAT_UBYTE4N },
+            },
+        },
+        // tested against the opaque pass, but drawn in order
+        .depth.compare = SG_COMPAREFUNC_LESS_EQUAL,
+        .colors[0].blend = m_pipeline_desc.colors[0].blend,
+        .index_type = SG_INDEXTYPE_UINT16,
+        .label = "QuadRenderer::instanced",
     };
-    m_vb = sg_make_buffer(&m_vb_desc);
+    m_instance_shader =
+        sg_make_shader(quad_instanced_shader_desc(shader_backend()));
+    instance_desc.shader = m_instance_shader;
+    m_instance_pipeline = sg_make_pipeline(&instance_desc);
+
+    // the texture array pipeline only differs in its fragment shader
+    m_array_shader = sg_make_shader(quad_array_shader_desc(shader_backend()));
+    instance_desc.shader = m_array_shader;
+    instance_desc.label = "QuadRenderer::array";
+    m_array_pipeline = sg_make_pipeline(&instance_desc);
 
-    m_ib_desc = {
+    // ... as does the opaque pass, which only differs in its depth & blending
+    instance_desc.depth.write_enabled = true;
+    instance_desc.colors[0].blend = {};
+    instance_desc.label = "QuadRenderer::opaque";
+    m_opaque_pipeline = sg_make_pipeline(&instance_desc);
+
+    const glm::vec2 corners[] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+    const uint16_t indices[] = { 0, 1, 2, 0, 3, 2 };
+    sg_buffer_desc unit_vb_desc = {
+        .type = SG_BUFFERTYPE_VERTEXBUFFER,
+        .data = SG_RANGE(corners),
+        .label = "QuadRenderer::m_unit_vb",
+    };
+    m_unit_vb = sg_make_buffer(&unit_vb_desc);
+    sg_buffer_desc unit_ib_desc = {
         .type = SG_BUFFERTYPE_INDEXBUFFER,
-        .usage = SG_USAGE_DYNAMIC,
-        .size = i_max * sizeof(uint16_t),
+        .data = SG_RANGE(indices),
+        .label = "QuadRenderer::m_unit_ib",
     };
-    m_ib = sg_make_buffer(&m_ib_desc);
+    m_unit_ib = sg_make_buffer(&unit_ib_desc);
 
     // create the white pixel image
     sg_image_desc m_desc = {
@@ -67,9 +136,15 @@ QuadRenderer::QuadRenderer(size_t v_max, size_t i_max)
 QuadRenderer::~QuadRenderer()
 {
     log_debug("destroy shader {}, pipeline {}, ib {}, vb {}",
-            m_shader.id, m_pipeline.id, m_ib.id, m_vb.id);
-    sg_destroy_buffer(m_ib);
-    sg_destroy_buffer(m_vb);
+            m_shader.id, m_pipeline.id, m_buf.i.buffer().id,
+            m_buf.v.buffer().id);
+    sg_destroy_buffer(m_unit_ib);
+    sg_destroy_buffer(m_unit_vb);
+    sg_destroy_pipeline(m_opaque_pipeline);
+    sg_destroy_pipeline(m_array_pipeline);
+    sg_destroy_shader(m_array_shader);
+    sg_destroy_pipeline(m_instance_pipeline);
+    sg_destroy_shader(m_instance_shader);
     sg_destroy_pipeline(m_pipeline);
     sg_destroy_shader(m_shader);
 }
@@ -79,44 +154,265 @@ QuadRenderer::clear()
 {
     m_buf.v.clear();
     m_buf.i.clear();
-    m_image_map.clear();
+    m_batches.clear();
+    next_batch();
+    m_instances.clear();
+    m_instance_batches.assign(1, {});
+    m_instance_last = 0;
+    m_layer_instances.clear();
+    m_opaque_instances.clear();
 }
 
 void
-QuadRenderer::render(glm::mat4& proj)
+QuadRenderer::set_origin(glm::ivec2 origin)
 {
-    if (m_buf.i.size() == 0) {
-        return;
-    }
+    assert((origin == m_origin || (m_buf.v.size() == 0
+            && m_instances.size() == 0 && m_layer_instances.size() == 0
+            && m_opaque_instances.size() == 0))
+        && "changing the origin of queued quads");
+    m_origin = origin;
+}
 
-    sg_apply_pipeline(m_pipeline);
+void
+QuadRenderer::apply_pipeline(
+    sg_pipeline pipeline, const View& view, glm::ivec2 origin)
+{
+    sg_apply_pipeline(pipeline);
 
-    // set the uniforms
-    vs_params_t params{ .u_mvp = proj };
+    // set the uniforms; both sides of the subtraction are close together, so
+    // the offset is exact even when they're far from the world origin
+    vs_params_t params{
+        .u_mvp = view.proj,
+        .u_origin = glm::vec2(origin) - view.camera,
+    };
     sg_range p = SG_RANGE(params);
     sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &p);
+}
+
+void
+QuadRenderer::next_batch()
+{
+    m_batches.push_back({
+        .vertex = m_buf.v.elements(),
+        .index = m_buf.i.elements(),
+    });
+    m_image_last = 0;
+}
+
+size_t
+QuadRenderer::bind_texture(
+    std::vector<Batch>& batches, sg_image texture, const Batch& next)
+{
+    Batch* batch = &batches.back();
+    size_t slot = 0;
+    while (slot < batch->image_count && batch->images[slot].id != texture.id) {
+        slot++;
+    }
+    if (slot == ImagesMax) {
+        // texture set is full
+        batch = &batches.emplace_back(next);
+        slot = 0;
+    }
+    if (slot == batch->image_count) {
+        batch->images[batch->image_count++] = texture;
+    }
+    return slot;
+}
+
+void
+QuadRenderer::draw_batches(sg_buffer vb, int vb_offset, sg_buffer ib,
+    int ib_offset, const std::vector<Batch>& batches)
+{
+    for (const auto& batch : batches) {
+        if (batch.elements == 0) {
+            continue;
+        }
+
+        // indices are relative to the batch, so offset the vertex buffer
+        m_bindings = {
+            .vertex_buffers[0] = vb,
+            .vertex_buffer_offsets[0] =
+                static_cast<int>(vb_offset + batch.vertex * sizeof(Vertex)),
+            .index_buffer = ib,
+            .index_buffer_offset = ib_offset,
+        };
+        for (size_t i = 0; i < ImagesMax; i++) {
+            m_bindings.fs_images[i] =
+                i < batch.image_count ? batch.images[i] : m_white_img;
+        }
+
+        sg_apply_bindings(&m_bindings);
+        sg_draw(batch.index, batch.elements, 1);
+    }
+}
+
+void
+QuadRenderer::draw_instances(int offset)
+{
+    for (const auto& batch : m_instance_batches) {
+        if (batch.elements == 0) {
+            continue;
+        }
 
+        m_bindings = {
+            .vertex_buffers[0] = m_unit_vb,
+            .vertex_buffers[1] = m_instances.buffer(),
+            .vertex_buffer_offsets[1] =
+                static_cast<int>(offset + batch.vertex * sizeof(Instance)),
+            .index_buffer = m_unit_ib,
+        };
+        for (size_t i = 0; i < ImagesMax; i++) {
+            m_bindings.fs_images[i] =
+                i < batch.image_count ? batch.images[i] : m_white_img;
+        }
+
+        sg_apply_bindings(&m_bindings);
+        sg_draw(0, 6, batch.elements);
+    }
+}
+
+void
+QuadRenderer::draw_layer_instances(sg_buffer instances, int offset,
+    size_t count)
+{
     m_bindings = {
-        .vertex_buffers[0] = m_vb,
-        .vertex_buffer_offsets[0] =
-            sg_append_buffer(m_vb, m_buf.v.sg_range()),
-        .index_buffer = m_ib,
-        .index_buffer_offset =
-            sg_append_buffer(m_ib, m_buf.i.sg_range()),
+        .vertex_buffers[0] = m_unit_vb,
+        .vertex_buffers[1] = instances,
+        .vertex_buffer_offsets[1] = offset,
+        .index_buffer = m_unit_ib,
+        .fs_images[SLOT_u_layers] = m_layers,
     };
+    sg_apply_bindings(&m_bindings);
+    sg_draw(0, 6, count);
+}
+
+void
+QuadRenderer::render_opaque(const View& view, glm::ivec2 origin,
+    sg_buffer instances, size_t count)
+{
+    assert(m_layers.id != SG_INVALID_ID);
+    if (count == 0) {
+        return;
+    }
+    apply_pipeline(m_opaque_pipeline, view, origin);
+    draw_layer_instances(instances, 0, count);
+}
+
+void
+QuadRenderer::render(const View& view)
+{
+    m_stats.quads = m_buf.i.elements() / 6;
+    m_stats.instances = m_instances.elements();
+    m_stats.layers = m_layer_instances.elements();
+    m_stats.opaque = m_opaque_instances.elements();
+    m_stats.batches = 0;
+    m_stats.batch_quads.clear();
+
+    // upload even when empty, to keep the utilization stats current
+    int vb_offset = m_buf.v.upload();
+    int ib_offset = m_buf.i.upload();
+    int instance_offset = m_instances.upload();
+    int layer_offset = m_layer_instances.upload();
+    int opaque_offset = m_opaque_instances.upload();
+    m_stats.vertices = m_buf.v.stats();
+    m_stats.indices = m_buf.i.stats();
+    m_stats.instance_buffer = m_instances.stats();
+    m_stats.layer_buffer = m_layer_instances.stats();
+    m_stats.opaque_buffer = m_opaque_instances.stats();
 
-    for (size_t i = 0; i < ImagesMax; i++) {
-        m_bindings.fs_images[i] = m_white_img;
+    // the opaque pass goes first, so everything after is tested against it
+    if (m_opaque_instances.size() > 0) {
+        apply_pipeline(m_opaque_pipeline, view, m_origin);
+        draw_layer_instances(m_opaque_instances.buffer(), opaque_offset,
+            m_opaque_instances.elements());
     }
 
-    // update our textures
-    for (const auto &p : m_image_map) {
-        m_bindings.fs_images[p.second] = {p.first};
+    if (m_buf.i.size() > 0) {
+        apply_pipeline(m_pipeline, view, m_origin);
+        draw_batches(m_buf.v.buffer(), vb_offset, m_buf.i.buffer(), ib_offset,
+            m_batches);
     }
 
-    // bind & draw
-    sg_apply_bindings(&m_bindings);
-    sg_draw(0, m_buf.i.elements(), 1);
+    if (m_instances.size() > 0) {
+        apply_pipeline(m_instance_pipeline, view, m_origin);
+        draw_instances(instance_offset);
+    }
+
+    if (m_layer_instances.size() > 0) {
+        apply_pipeline(m_array_pipeline, view, m_origin);
+        draw_layer_instances(m_layer_instances.buffer(), layer_offset,
+            m_layer_instances.elements());
+    }
+
+    for (const auto& batch : m_batches) {
+        if (batch.elements > 0) {
+            m_stats.batches++;
+            m_stats.batch_quads.push_back(batch.elements / 6);
+        }
+    }
+    for (const auto& batch : m_instance_batches) {
+        if (batch.elements > 0) {
+            m_stats.batches++;
+            m_stats.batch_quads.push_back(batch.elements);
+        }
+    }
+    for (size_t layers : { m_stats.opaque, m_stats.layers }) {
+        if (layers > 0) {
+            m_stats.batches++;
+            m_stats.batch_quads.push_back(layers);
+        }
+    }
+}
+
+void
+QuadRenderer::render(const View& view, const Mesh& mesh)
+{
+    if (mesh.batches.empty()) {
+        return;
+    }
+
+    apply_pipeline(m_pipeline, view, mesh.origin);
+    draw_batches(mesh.vb, 0, mesh.ib, 0, mesh.batches);
+}
+
+QuadRenderer::Mesh
+QuadRenderer::bake()
+{
+    Mesh mesh{};
+    if (m_buf.i.size() == 0) {
+        return mesh;
+    }
+
+    sg_buffer_desc vb_desc = {
+        .type = SG_BUFFERTYPE_VERTEXBUFFER,
+        .usage = SG_USAGE_IMMUTABLE,
+        .data = m_buf.v.sg_range(),
+        .label = "QuadRenderer::Mesh::vb",
+    };
+    sg_buffer_desc ib_desc = {
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .usage = SG_USAGE_IMMUTABLE,
+        .data = m_buf.i.sg_range(),
+        .label = "QuadRenderer::Mesh::ib",
+    };
+    mesh.origin = m_origin;
+    mesh.vb = sg_make_buffer(&vb_desc);
+    mesh.ib = sg_make_buffer(&ib_desc);
+    mesh.batches = m_batches;
+
+    clear();
+    return mesh;
+}
+
+void
+QuadRenderer::destroy(Mesh& mesh)
+{
+    if (mesh.batches.empty()) {
+        return;
+    }
+    sg_destroy_buffer(mesh.ib);
+    sg_destroy_buffer(mesh.vb);
+    mesh = {};
 }
 
 void
@@ -124,7 +420,7 @@ QuadRenderer::draw_rect(
         glm::vec2 pos,
         glm::vec2 size,
         sg_image texture,
-        glm::mat3 t_transform)
+        glm::vec4 uv)
 {
     static const glm::vec3 quad[] = {
         {  0.0f,  0.0f, 1.0f },
@@ -134,28 +430,34 @@ QuadRenderer::draw_rect(
     };
     assert(texture.id != SG_INVALID_ID);
 
-    int t_idx = -1;
-    if (const auto &p = m_image_map.find(texture.id); p != m_image_map.end()) {
-        t_idx = p->second;
-    } else {
-        t_idx = m_image_map[texture.id] = m_image_map.size();
-        // log_debug("added texture {} -> index {}", texture.id, t_idx);
+    // the indices of this batch can't reach any more vertices
+    if (m_buf.v.elements() + 4 - m_batches.back().vertex > BatchVerticesMax) {
+        next_batch();
+    }
+
+    // sprites are almost all drawn from the same atlas page, so only search
+    // the textures when it differs from the last quad's
+    if (texture.id != m_batches.back().images[m_image_last].id) {
+        m_image_last = bind_texture(m_batches, texture,
+            { .vertex = m_buf.v.elements(), .index = m_buf.i.elements() });
     }
-    assert(m_image_map.size() <= ImagesMax && "too many images");
+    Batch& batch = m_batches.back();
 
+    pos = relative(pos, m_origin);
     glm::mat3 transform{
         { static_cast<float>(size.x), 0.0f, 0.0f },
         { 0.0f, static_cast<float>(size.y), 0.0f },
         { static_cast<float>(pos.x), static_cast<float>(pos.y), 1.0f },
     };
 
-    uint16_t base = m_buf.v.elements();
+    glm::vec2 uv_pos{ uv.x, uv.y }, uv_size{ uv.z, uv.w };
+    uint16_t base = m_buf.v.elements() - batch.vertex;
     for (int i = 0; i < 4; i++) {
         //log_debug("quad[{}] {} -> {}", i, quad[i], transform * quad[i]);
         m_buf.v.push_back({
                 transform * quad[i],
-                static_cast<float>(t_idx),
-                t_transform * quad[i],
+                static_cast<float>(m_image_last),
+                uv_pos + glm::vec2(quad[i]) * uv_size,
                 {255, 255, 255, 255},
             });
     }
@@ -163,6 +465,372 @@ QuadRenderer::draw_rect(
             (uint16_t)base, (uint16_t)(base + 1), (uint16_t)(base + 2),
             (uint16_t)base, (uint16_t)(base + 3), (uint16_t)(base + 2),
         });
+    batch.elements += 6;
+}
+
+void
+QuadRenderer::draw_rects(sg_image texture, const Rects& rects)
+{
+    static const quad_kernel::Expand expand = quad_kernel::best();
+    assert(texture.id != SG_INVALID_ID);
+    assert(rects.size.size() == rects.pos.size()
+        && rects.uv.size() == rects.pos.size());
+
+    size_t count = rects.pos.size();
+    for (size_t first = 0; first < count;) {
+        // as many quads as the current batch's indices can still reach
+        size_t room = (BatchVerticesMax - (m_buf.v.elements()
+            - m_batches.back().vertex)) / 4;
+        if (room == 0) {
+            next_batch();
+            continue;
+        }
+        if (texture.id != m_batches.back().images[m_image_last].id) {
+            m_image_last = bind_texture(m_batches, texture,
+                { .vertex = m_buf.v.elements(), .index = m_buf.i.elements() });
+        }
+        Batch& batch = m_batches.back();
+
+        size_t n = std::min(room, count - first);
+#ifndef NDEBUG
+        for (size_t q = first; q < first + n; q++) {
+            relative(rects.pos[q], m_origin);
+        }
+#endif
+        uint16_t base = m_buf.v.elements() - batch.vertex;
+        expand(&rects.pos[first], &rects.size[first], &rects.uv[first], n,
+            glm::vec2(m_origin), static_cast<float>(m_image_last), base,
+            m_buf.v.extend(n * 4), m_buf.i.extend(n * 6));
+        batch.elements += n * 6;
+        first += n;
+    }
+}
+
+void
+QuadRenderer::draw_sprite(
+        glm::vec2 pos,
+        glm::vec2 size,
+        sg_image texture,
+        glm::vec4 uv,
+        int z)
+{
+    assert(texture.id != SG_INVALID_ID);
+
+    if (texture.id != m_instance_batches.back().images[m_instance_last].id) {
+        m_instance_last = bind_texture(m_instance_batches, texture,
+            { .vertex = m_instances.elements() });
+    }
+
+    m_instances.push_back(instance(
+        relative(pos, m_origin), size, m_instance_last, uv, z));
+    m_instance_batches.back().elements++;
+}
+
+QuadRenderer::Instance
+QuadRenderer::instance(
+        glm::vec2 pos,
+        glm::vec2 size,
+        size_t slot,
+        glm::vec4 uv,
+        int z)
+{
+    return {
+        { static_cast<int16_t>(pos.x), static_cast<int16_t>(pos.y) },
+        { static_cast<int16_t>(size.x), static_cast<int16_t>(size.y) },
+        uv,
+        static_cast<int16_t>(slot),
+        static_cast<int16_t>(z),
+        {255, 255, 255, 255},
+    };
+}
+
+QuadRenderer::Instance
+QuadRenderer::layer_instance(const LayerQuad& q, glm::ivec2 origin)
+{
+    return instance(relative(q.pos, origin), q.size, q.layer, q.uv, q.z);
+}
+
+std::array<uint32_t, QuadRenderer::ImagesMax>
+QuadRenderer::capture_textures(capture::Frame& frame, const Batch& batch)
+{
+    std::array<uint32_t, ImagesMax> index{};
+    for (size_t i = 0; i < batch.image_count; i++) {
+        auto desc = sg_query_image_desc(batch.images[i]);
+        index[i] = frame.texture(batch.images[i].id, desc.width, desc.height);
+    }
+    return index;
+}
+
+void
+QuadRenderer::capture(capture::Frame& frame) const
+{
+    frame.header.origin = m_origin;
+
+    // every draw_rect() adds four vertices & six indices to its batch
+    for (const auto& batch : m_batches) {
+        auto texture = capture_textures(frame, batch);
+        for (size_t q = 0; q < batch.elements / 6; q++) {
+            const Vertex& v0 = m_buf.v.at(batch.vertex + q * 4);
+            const Vertex& v2 = m_buf.v.at(batch.vertex + q * 4 + 2);
+            frame.rects.push_back({
+                v0.pos,
+                v2.pos - v0.pos,
+                { v0.texture_pos, v2.texture_pos - v0.texture_pos },
+                texture[static_cast<size_t>(v0.texture)],
+                0,
+            });
+        }
+    }
+
+    for (const auto& batch : m_instance_batches) {
+        auto texture = capture_textures(frame, batch);
+        for (size_t n = 0; n < batch.elements; n++) {
+            const Instance& inst = m_instances.at(batch.vertex + n);
+            frame.sprites.push_back({
+                inst.pos,
+                inst.size,
+                inst.uv,
+                texture[static_cast<size_t>(inst.texture)],
+                inst.z,
+            });
+        }
+    }
+
+    if (m_layer_instances.size() > 0 || m_opaque_instances.size() > 0) {
+        capture_layers(frame);
+    }
+    for (auto [instances, quads] : {
+             std::pair{ &m_layer_instances, &frame.layers },
+             std::pair{ &m_opaque_instances, &frame.opaque } }) {
+        for (size_t n = 0; n < instances->elements(); n++) {
+            const Instance& inst = instances->at(n);
+            quads->push_back({ inst.pos, inst.size, inst.uv,
+                static_cast<uint32_t>(inst.texture), inst.z });
+        }
+    }
+}
+
+void
+QuadRenderer::capture_layers(capture::Frame& frame) const
+{
+    auto desc = sg_query_image_desc(m_layers);
+    frame.header.layer_texture =
+        frame.texture(m_layers.id, desc.width, desc.height);
+}
+
+void
+QuadRenderer::capture_opaque(capture::Frame& frame, glm::ivec2 origin,
+    std::span<const Instance> instances) const
+{
+    if (instances.empty()) {
+        return;
+    }
+    capture_layers(frame);
+
+    // rebase onto the frame's origin; anything drawn is on screen, so well
+    // within 16 bits of it
+    glm::vec<2, int16_t> offset(origin - frame.header.origin);
+    for (const Instance& inst : instances) {
+        // freed slots are left in the buffer with no size
+        if (inst.size == glm::vec<2, int16_t>(0)) {
+            continue;
+        }
+        frame.opaque.push_back({
+            inst.pos + offset,
+            inst.size,
+            inst.uv,
+            static_cast<uint32_t>(inst.texture),
+            inst.z,
+        });
+    }
+}
+
+namespace {
+/// small set of texture ids, that notes when it overflows ImagesMax
+struct TextureSet {
+    std::array<uint32_t, QuadRenderer::ImagesMax> ids{};
+    size_t count{ 0 };
+    bool overflow{ false };
+
+    inline int find(uint32_t id) const {
+        for (size_t i = 0; i < count; i++) {
+            if (ids[i] == id) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    inline void add(uint32_t id) {
+        if (find(id) >= 0) {
+            return;
+        } else if (count == ids.size()) {
+            overflow = true;
+        } else {
+            ids[count++] = id;
+        }
+    }
+};
+} // namespace
+
+void
+QuadRenderer::draw_sprites(thread_pool& pool, size_t count,
+    const std::function<Quad(size_t)>& quad)
+{
+    if (count == 0) {
+        return;
+    }
+    size_t chunks = (count + SpriteChunk - 1) / SpriteChunk;
+    auto chunk_end = [&](size_t c) {
+        return std::min(count, (c + 1) * SpriteChunk);
+    };
+
+    // find the textures used by each chunk
+    std::vector<TextureSet> used(chunks);
+    pool.parallel_for(chunks, [&](size_t c) {
+        uint32_t last = SG_INVALID_ID;
+        for (size_t i = c * SpriteChunk; i < chunk_end(c); i++) {
+            uint32_t id = quad(i).texture.id;
+            if (id != last) {
+                used[c].add(id);
+                last = id;
+            }
+        }
+    });
+
+    // all of the sprites have to fit in a single batch for the instances to
+    // be written in parallel; start a new one if the current one can't fit
+    // them.
+    TextureSet all;
+    for (const auto& set : used) {
+        all.overflow |= set.overflow;
+        for (size_t i = 0; i < set.count; i++) {
+            all.add(set.ids[i]);
+        }
+    }
+    TextureSet batch_set = all;
+    const Batch& current = m_instance_batches.back();
+    for (size_t i = 0; i < current.image_count; i++) {
+        batch_set.add(current.images[i].id);
+    }
+    if (all.overflow) {
+        // more textures than a single batch supports; batch them in order
+        for (size_t i = 0; i < count; i++) {
+            Quad q = quad(i);
+            draw_sprite(q.pos, q.size, q.texture, q.uv, q.z);
+        }
+        return;
+    }
+    if (batch_set.overflow) {
+        m_instance_batches.push_back({ .vertex = m_instances.elements() });
+    }
+
+    // bind the textures, and get the slot of every texture id
+    Batch& batch = m_instance_batches.back();
+    TextureSet slots;
+    for (size_t i = 0; i < batch.image_count; i++) {
+        slots.add(batch.images[i].id);
+    }
+    for (size_t i = 0; i < all.count; i++) {
+        if (slots.find(all.ids[i]) < 0) {
+            slots.add(all.ids[i]);
+            batch.images[batch.image_count++] = { all.ids[i] };
+        }
+    }
+    m_instance_last = 0;
+
+    // each chunk writes its instances directly to its slice of the buffer
+    size_t first = m_instances.elements();
+    m_instances.resize(first + count);
+    Instance* out = &m_instances.at(first);
+    pool.parallel_for(chunks, [&](size_t c) {
+        uint32_t last = SG_INVALID_ID;
+        size_t slot = 0;
+        for (size_t i = c * SpriteChunk; i < chunk_end(c); i++) {
+            Quad q = quad(i);
+            if (q.texture.id != last) {
+                last = q.texture.id;
+                slot = slots.find(last);
+            }
+            out[i] = instance(
+                relative(q.pos, m_origin), q.size, slot, q.uv, q.z);
+        }
+    });
+    batch.elements += count;
+}
+
+void
+QuadRenderer::set_layers(sg_image array)
+{
+    assert((array.id == m_layers.id || (m_layer_instances.size() == 0
+            && m_opaque_instances.size() == 0))
+        && "texture array changed with layers queued");
+    m_layers = array;
+}
+
+void
+QuadRenderer::draw_layer(
+        glm::vec2 pos,
+        glm::vec2 size,
+        uint16_t layer,
+        glm::vec4 uv,
+        int z)
+{
+    assert(m_layers.id != SG_INVALID_ID);
+    m_layer_instances.push_back(
+        instance(relative(pos, m_origin), size, layer, uv, z));
+}
+
+void
+QuadRenderer::draw_layers(thread_pool& pool, size_t count,
+    const std::function<LayerQuad(size_t)>& quad)
+{
+    write_layers(m_layer_instances, pool, count, quad);
+}
+
+void
+QuadRenderer::draw_opaque_layer(
+        glm::vec2 pos,
+        glm::vec2 size,
+        uint16_t layer,
+        glm::vec4 uv,
+        int z)
+{
+    assert(m_layers.id != SG_INVALID_ID);
+    m_opaque_instances.push_back(
+        instance(relative(pos, m_origin), size, layer, uv, z));
+}
+
+void
+QuadRenderer::draw_opaque_layers(thread_pool& pool, size_t count,
+    const std::function<LayerQuad(size_t)>& quad)
+{
+    write_layers(m_opaque_instances, pool, count, quad);
+}
+
+void
+QuadRenderer::write_layers(StreamBuffer<Instance>& instances,
+    thread_pool& pool, size_t count,
+    const std::function<LayerQuad(size_t)>& quad)
+{
+    assert(m_layers.id != SG_INVALID_ID);
+    if (count == 0) {
+        return;
+    }
+
+    // with no texture slots to resolve, every chunk writes its instances
+    // directly to its slice of the buffer
+    size_t first = instances.elements();
+    instances.resize(first + count);
+    Instance* out = &instances.at(first);
+    size_t chunks = (count + SpriteChunk - 1) / SpriteChunk;
+    pool.parallel_for(chunks, [&](size_t c) {
+        size_t end = std::min(count, (c + 1) * SpriteChunk);
+        for (size_t i = c * SpriteChunk; i < end; i++) {
+            LayerQuad q = quad(i);
+            out[i] = instance(
+                relative(q.pos, m_origin), q.size, q.layer, q.uv, q.z);
+        }
+    });
 }
 
 } // namespace render
@@ -1,55 +1,290 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <functional>
+#include <span>
+#include <vector>
 #include <glm/glm.hpp>
 #include <sokol_gfx.h>
 #include "rgba.hpp"
 #include "buffer.hpp"
+#include "stream_buffer.hpp"
+
+class thread_pool;
 
 namespace render {
 
+namespace capture { struct Frame; }
+
 class QuadRenderer
 {
 public:
     // maximum number of textures the shader supports
-    const size_t ImagesMax = 4;
+    static constexpr size_t ImagesMax = 4;
+
+    // maximum number of vertices addressable by a batch's uint16_t indices
+    static constexpr size_t BatchVerticesMax = 1 << 16;
+
+    // number of sprites each thread generates at a time in draw_sprites()
+    static constexpr size_t SpriteChunk = 1024;
 
     using rgba = glm::vec<4, uint8_t>;
 
+    /// pos is relative to the renderer's origin; see set_origin()
     struct Vertex
     {
-        glm::vec<2, uint16_t> pos;
+        glm::vec<2, int16_t> pos;
         float texture;
         glm::vec2 texture_pos;
         rgba color;
     };
 
+    /// per-sprite record for the instanced pipeline; see draw_sprite()
+    struct Instance
+    {
+        glm::vec<2, int16_t> pos;   // relative to the origin, like Vertex
+        glm::vec<2, int16_t> size;
+        glm::vec4 uv;       // top-left & size of the crop, normalized
+        int16_t texture;    // slot, or layer for the texture array
+        int16_t z;          // read with texture as a single SHORT2
+        rgba color;
+    };
+
     struct BufferPair {
-        Buffer<Vertex> v;
-        IndexBuffer i;
+        StreamBuffer<Vertex> v;
+        StreamBuffer<uint16_t> i;
+    };
+
+    /// quads drawn with a single draw call
+    ///
+    /// A new batch is started whenever a quad needs a texture that doesn't
+    /// fit in the current batch's texture set, or a vertex beyond the reach
+    /// of its 16-bit indices.  Batch indices are relative to the batch's
+    /// first vertex.
+    struct Batch {
+        size_t vertex{ 0 };     // first vertex
+        size_t index{ 0 };      // first index
+        size_t elements{ 0 };   // number of indices
+        std::array<sg_image, ImagesMax> images{};
+        size_t image_count{ 0 };
+    };
+
+    /// quads uploaded once into immutable GPU buffers; see bake()
+    struct Mesh {
+        glm::ivec2 origin{ 0 };     // origin the vertices were drawn with
+        sg_buffer vb{};
+        sg_buffer ib{};
+        std::vector<Batch> batches{};
+    };
+
+    /// arguments for draw_sprite(), as returned to draw_sprites()
+    struct Quad {
+        glm::vec2 pos;
+        glm::vec2 size;
+        sg_image texture;
+        glm::vec4 uv;
+        int z;
+    };
+
+    /// quads for draw_rects(), as parallel arrays of draw_rect()'s arguments
+    struct Rects {
+        std::span<const glm::vec2> pos;
+        std::span<const glm::vec2> size;
+        std::span<const glm::vec4> uv;
+    };
+
+    /// arguments for draw_layer(), as returned to draw_layers()
+    struct LayerQuad {
+        glm::vec2 pos;
+        glm::vec2 size;
+        uint16_t layer;
+        glm::vec4 uv;
+        int z;
+    };
+
+    /// what render() draws
+    ///
+    /// proj maps positions relative to the camera to clip space, so it only
+    /// ever holds screen-sized values no matter how far the camera is from
+    /// the world origin.
+    struct View {
+        glm::mat4 proj;
+        glm::vec2 camera;
+    };
+
+    /// counts from the last call to render()
+    struct Stats {
+        size_t quads{ 0 };
+        size_t instances{ 0 };
+        size_t layers{ 0 };     // instances drawn with draw_layer()
+        size_t opaque{ 0 };     // instances drawn with draw_opaque_layer()
+        size_t batches{ 0 };
+        std::vector<size_t> batch_quads{};  // quads or instances per batch
+        StreamStats vertices{};
+        StreamStats indices{};
+        StreamStats instance_buffer{};
+        StreamStats layer_buffer{};
+        StreamStats opaque_buffer{};
     };
 
     QuadRenderer(size_t v_max, size_t i_max);
     ~QuadRenderer();
     void clear();
-    void render(glm::mat4&);
+    void render(const View&);
+    void render(const View&, const Mesh&);
+
+    /// set the point quads are positioned relative to
+    ///
+    /// Positions are stored as 16-bit offsets from the origin, so every quad
+    /// drawn until the next clear() must lie within +/-32k of it; the origin
+    /// can only change while no quads are queued.
+    void set_origin(glm::ivec2 origin);
+    inline glm::ivec2 origin() const { return m_origin; }
+
+    /// move the quads drawn since the last clear() into an immutable Mesh;
+    /// the caller owns the Mesh, and must release it with destroy()
+    Mesh bake();
+    static void destroy(Mesh&);
+
+    inline const Stats& stats() const { return m_stats; }
+
+    /// append the quads drawn since the last clear() to a capture frame
+    void capture(capture::Frame&) const;
+
+    /// append instances drawn with render_opaque() from a buffer relative to
+    /// `origin` to a capture frame's opaque quads; call after capture()
+    void capture_opaque(capture::Frame&, glm::ivec2 origin,
+        std::span<const Instance> instances) const;
+
+    /// draw a quad by expanding it into vertices; only these are baked
+    ///
+    /// uv is the top-left & size of the crop of texture to draw, normalized,
+    /// as stored in SpriteFrames.
     void draw_rect(
         glm::vec2 pos,
         glm::vec2 size,
         sg_image texture,
-        glm::mat3 texture_transform);
+        glm::vec4 uv);
+
+    /// draw_rect() for every quad in rects, all from the same texture
+    ///
+    /// The quads are expanded in bulk by the fastest kernel in quad_kernel,
+    /// straight into the vertex & index buffers.
+    void draw_rects(sg_image texture, const Rects& rects);
+
+    /// draw a quad as a single instance, expanded by the vertex shader
+    ///
+    /// z is the quad's draw order; quads are still drawn in the order they
+    /// are submitted, but are hidden behind any opaque quad in front of them.
+    void draw_sprite(
+        glm::vec2 pos,
+        glm::vec2 size,
+        sg_image texture,
+        glm::vec4 uv,
+        int z = 0);
+
+    /// draw_sprite() for `count` quads, in order, with the instances
+    /// generated in parallel across the pool; `quad(i)` returns the i'th
+    /// quad, and is called from the pool's threads.
+    void draw_sprites(thread_pool&, size_t count,
+        const std::function<Quad(size_t)>& quad);
+
+    /// set the texture array draw_layer() draws from; like the origin, it
+    /// can only change while no layers are queued
+    void set_layers(sg_image array);
+
+    /// draw a quad from a layer of the texture array as a single instance
+    ///
+    /// The shader samples the array with the layer directly, so there are no
+    /// texture slots or batches; all layers are drawn by one draw call,
+    /// after the quads from draw_rect() & draw_sprite().
+    void draw_layer(
+        glm::vec2 pos,
+        glm::vec2 size,
+        uint16_t layer,
+        glm::vec4 uv,
+        int z = 0);
+
+    /// draw_layer() for `count` quads, in order, generated in parallel across
+    /// the pool like draw_sprites()
+    void draw_layers(thread_pool&, size_t count,
+        const std::function<LayerQuad(size_t)>& quad);
+
+    /// draw a quad with no transparent pixels from the texture array, in any
+    /// order
+    ///
+    /// Opaque quads are drawn first, without blending, writing a depth made
+    /// from their z & y; the depth test then gives the same result as
+    /// drawing them in z, then y order, and every other instanced quad is
+    /// hidden behind the opaque quads in front of it.  Only z between -128
+    /// and 127, and y within 1k pixels of the camera, are ordered.
+    void draw_opaque_layer(
+        glm::vec2 pos,
+        glm::vec2 size,
+        uint16_t layer,
+        glm::vec4 uv,
+        int z);
+
+    /// draw_opaque_layer() for `count` quads, generated in parallel across
+    /// the pool like draw_layers()
+    void draw_opaque_layers(thread_pool&, size_t count,
+        const std::function<LayerQuad(size_t)>& quad);
+
+    /// the instance draw_layer() writes for a quad, relative to `origin`;
+    /// for instances kept in buffers of the caller's own
+    static Instance layer_instance(const LayerQuad&, glm::ivec2 origin);
+
+    /// draw `count` instances from a buffer of layer_instance()s through the
+    /// opaque pass, from the texture array set with set_layers()
+    ///
+    /// Call before render(), so its quads are tested against these.
+    void render_opaque(const View&, glm::ivec2 origin, sg_buffer instances,
+        size_t count);
 
 private:
+    void apply_pipeline(sg_pipeline, const View&, glm::ivec2 origin);
+    void next_batch();
+    size_t bind_texture(std::vector<Batch>&, sg_image, const Batch& next);
+    void draw_batches(sg_buffer vb, int vb_offset, sg_buffer ib,
+        int ib_offset, const std::vector<Batch>&);
+    void draw_instances(int offset);
+    void draw_layer_instances(sg_buffer, int offset, size_t count);
+    static std::array<uint32_t, ImagesMax> capture_textures(
+        capture::Frame&, const Batch&);
+    void capture_layers(capture::Frame&) const;
+    void write_layers(StreamBuffer<Instance>&, thread_pool&, size_t count,
+        const std::function<LayerQuad(size_t)>& quad);
+    static Instance instance(glm::vec2 pos, glm::vec2 size, size_t slot,
+        glm::vec4 uv, int z);
 
     sg_pipeline_desc m_pipeline_desc;
     sg_pipeline m_pipeline;
     sg_shader m_shader;
-    sg_buffer_desc m_vb_desc, m_ib_desc;
-    sg_buffer m_vb, m_ib;
     sg_bindings m_bindings{};
     sg_image m_white_img;
-    std::map<uint32_t, size_t> m_image_map{};
+    glm::ivec2 m_origin{ 0 };
+    std::vector<Batch> m_batches{};
+    size_t m_image_last{ 0 };   // slot of the last texture drawn
     BufferPair m_buf;
+
+    // instanced pipeline; batches index instances rather than vertices
+    sg_pipeline m_instance_pipeline;
+    sg_shader m_instance_shader;
+    sg_buffer m_unit_vb, m_unit_ib;
+    StreamBuffer<Instance> m_instances;
+    std::vector<Batch> m_instance_batches{};
+    size_t m_instance_last{ 0 };
+
+    // texture array pipeline; instances hold a layer in place of a slot
+    sg_pipeline m_array_pipeline;
+    sg_shader m_array_shader;
+    sg_image m_layers{};
+    StreamBuffer<Instance> m_layer_instances;
+
+    // opaque pass; texture array instances with depth writes & no blending
+    sg_pipeline m_opaque_pipeline;
+    StreamBuffer<Instance> m_opaque_instances;
+    Stats m_stats{};
 };
 
 } // namespace render
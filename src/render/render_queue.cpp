@@ -0,0 +1,47 @@
+#include <array>
+#include "render_queue.hpp"
+
+namespace render {
+
+void
+RenderQueue::sort()
+{
+    constexpr size_t PASSES = sizeof(uint64_t);
+    size_t count = m_items.size();
+    if (count < 2) {
+        return;
+    }
+
+    // histogram every byte of the key in a single read of the queue
+    std::array<std::array<uint32_t, 256>, PASSES> counts{};
+    for (const auto& item : m_items) {
+        for (size_t pass = 0; pass < PASSES; pass++) {
+            counts[pass][(item.key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    m_scratch.resize(count);
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        auto& hist = counts[pass];
+        unsigned shift = pass * 8;
+
+        // skip bytes that are the same in every key, like the z of a scene
+        // that only uses a couple of layers
+        if (hist[(m_items[0].key >> shift) & 0xff] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (auto& c : hist) {
+            uint32_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const auto& item : m_items) {
+            m_scratch[hist[(item.key >> shift) & 0xff]++] = item;
+        }
+        m_items.swap(m_scratch);
+    }
+}
+
+} // namespace render
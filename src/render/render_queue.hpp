@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace render {
+
+/// list of things to draw this frame, ordered by 64-bit sort keys
+///
+/// Each item is a sort key, and a payload for the caller to find what to
+/// draw; usually an index into its own array.  Keys are ordered with a
+/// stable LSD radix sort, so building & sorting the queue every frame is
+/// O(n), regardless of how much moved since the last frame.
+class RenderQueue {
+public:
+    struct Item {
+        uint64_t key;
+        uint32_t payload;
+    };
+
+    /// sort key for a sprite; ordered by z, then y, then texture to keep
+    /// sprites sharing a texture together
+    ///
+    /// z is truncated to 16 bits, and the texture to the 16-bit slot index
+    /// of a sokol resource id.
+    static inline uint64_t key(int z, float y, uint32_t texture) {
+        return static_cast<uint64_t>(static_cast<uint16_t>(z ^ 0x8000)) << 48
+            | static_cast<uint64_t>(ordered(y)) << 16
+            | (texture & 0xffff);
+    }
+
+    inline void clear() { m_items.clear(); }
+    inline void reserve(size_t count) { m_items.reserve(count); }
+    inline void push(uint64_t key, uint32_t payload) {
+        m_items.push_back({ key, payload });
+    }
+
+    /// stable sort of the queue by key
+    void sort();
+
+    inline size_t size() const { return m_items.size(); }
+    inline auto begin() const { return m_items.begin(); }
+    inline auto end() const { return m_items.end(); }
+
+private:
+    /// map a float to a uint32_t with the same ordering
+    static inline uint32_t ordered(float f) {
+        uint32_t u = std::bit_cast<uint32_t>(f);
+        return u & 0x80000000 ? ~u : u | 0x80000000;
+    }
+
+    std::vector<Item> m_items{};
+    std::vector<Item> m_scratch{};
+};
+
+} // namespace render
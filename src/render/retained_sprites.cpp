@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstdint>
+#include "../log.hpp"
+#include "../render.hpp"
+#include "retained_sprites.hpp"
+
+namespace render {
+
+RetainedSprites::~RetainedSprites()
+{
+    for (auto& [key, chunk] : m_chunks) {
+        for (auto& page : chunk.pages) {
+            sg_destroy_buffer(page.buf);
+        }
+    }
+}
+
+void
+RetainedSprites::update(entt::entity e, const QuadRenderer::LayerQuad& quad)
+{
+    uint64_t key = chunk_key(quad.pos);
+    auto it = m_slots.find(e);
+    if (it != m_slots.end() && it->second.chunk != key) {
+        remove(e);
+        it = m_slots.end();
+    }
+    if (it == m_slots.end()) {
+        auto& slots = m_chunk_slots[key];
+        uint32_t index;
+        if (slots.free.empty()) {
+            index = slots.next++;
+        } else {
+            index = slots.free.back();
+            slots.free.pop_back();
+        }
+        it = m_slots.emplace(e, Slot{ key, index }).first;
+    }
+    m_queued.push_back({ it->second, quad });
+}
+
+void
+RetainedSprites::remove(entt::entity e)
+{
+    auto it = m_slots.find(e);
+    if (it == m_slots.end()) {
+        return;
+    }
+    m_queued.push_back({ it->second, {} });
+    m_chunk_slots[it->second.chunk].free.push_back(it->second.index);
+    m_slots.erase(it);
+}
+
+void
+RetainedSprites::clear()
+{
+    m_slots.clear();
+    m_chunk_slots.clear();
+    m_queued.clear();
+    m_queued_clear = true;
+}
+
+void
+RetainedSprites::publish()
+{
+    std::lock_guard lock(m_mutex);
+
+    // writes the main thread hasn't picked up yet are all for slots that
+    // are about to be freed
+    if (m_queued_clear) {
+        m_published.clear();
+        m_published_clear = true;
+        m_queued_clear = false;
+    }
+    m_published.insert(m_published.end(), m_queued.begin(), m_queued.end());
+    m_queued.clear();
+}
+
+void
+RetainedSprites::apply()
+{
+    bool clear;
+    {
+        std::lock_guard lock(m_mutex);
+        std::swap(m_applying, m_published);
+        clear = m_published_clear;
+        m_published_clear = false;
+    }
+
+    // every slot is written when it's assigned, so after a clear only the
+    // slots written since are drawn; the pages are kept for reuse
+    if (clear) {
+        for (auto& [key, chunk] : m_chunks) {
+            chunk.count = 0;
+            chunk.min = chunk.max = glm::vec2(chunk.origin);
+        }
+    }
+    for (const auto& w : m_applying) {
+        auto [it, added] = m_chunks.try_emplace(w.slot.chunk);
+        auto& chunk = it->second;
+        if (added) {
+            glm::ivec2 coords{ static_cast<int32_t>(w.slot.chunk >> 32),
+                static_cast<int32_t>(w.slot.chunk & 0xffffffff) };
+            chunk.origin = { coords.x * static_cast<int>(RESOLUTION.x),
+                coords.y * static_cast<int>(RESOLUTION.y) };
+            chunk.min = chunk.max = glm::vec2(chunk.origin);
+        }
+
+        size_t index = w.slot.index / PageSlots;
+        while (index >= chunk.pages.size()) {
+            sg_buffer_desc desc = {
+                .size = PageSlots * sizeof(QuadRenderer::Instance),
+                .type = SG_BUFFERTYPE_VERTEXBUFFER,
+                .usage = SG_USAGE_DYNAMIC,
+                .label = "RetainedSprites::Page",
+            };
+            auto& page = chunk.pages.emplace_back();
+            page.buf = sg_make_buffer(&desc);
+            page.instances.resize(PageSlots);
+            log_debug("retained sprites: add page {} to chunk at {},{}",
+                chunk.pages.size() - 1, chunk.origin.x, chunk.origin.y);
+        }
+
+        // bounds only grow until the next clear, so freed slots are never
+        // culled too early
+        auto& page = chunk.pages[index];
+        page.instances[w.slot.index % PageSlots] =
+            QuadRenderer::layer_instance(w.quad, chunk.origin);
+        page.dirty = true;
+        chunk.count =
+            std::max(chunk.count, static_cast<size_t>(w.slot.index) + 1);
+        if (w.quad.size != glm::vec2(0)) {
+            chunk.min = glm::min(chunk.min, w.quad.pos);
+            chunk.max = glm::max(chunk.max, w.quad.pos + w.quad.size);
+        }
+    }
+    m_stats.writes = m_applying.size();
+    m_applying.clear();
+
+    // dynamic buffers can only be updated whole, once a frame, so upload the
+    // pages with any slot rewritten, up to the last slot drawn
+    m_stats.uploaded = 0;
+    m_stats.slots = 0;
+    m_stats.pages = 0;
+    for (auto& [key, chunk] : m_chunks) {
+        for (size_t i = 0; i < chunk.pages.size(); i++) {
+            auto& page = chunk.pages[i];
+            size_t first = i * PageSlots;
+            if (!page.dirty || first >= chunk.count) {
+                continue;
+            }
+            size_t count = std::min(PageSlots, chunk.count - first);
+            sg_range data = {
+                .ptr = page.instances.data(),
+                .size = count * sizeof(QuadRenderer::Instance),
+            };
+            sg_update_buffer(page.buf, &data);
+            page.dirty = false;
+            m_stats.uploaded++;
+        }
+        m_stats.slots += chunk.count;
+        m_stats.pages += (chunk.count + PageSlots - 1) / PageSlots;
+    }
+    m_stats.chunks = m_chunks.size();
+}
+
+void
+RetainedSprites::render(QuadRenderer& quads, const QuadRenderer::View& view)
+{
+    glm::vec2 min = view.camera;
+    glm::vec2 max{ min.x + RESOLUTION.x, min.y + RESOLUTION.y };
+
+    m_stats.drawn = 0;
+    m_drawn.clear();
+    for (auto& [key, chunk] : m_chunks) {
+        if (chunk.count == 0 || chunk.max.x <= min.x || chunk.min.x >= max.x
+            || chunk.max.y <= min.y || chunk.min.y >= max.y) {
+            continue;
+        }
+        m_drawn.push_back(&chunk);
+        for (size_t i = 0; i * PageSlots < chunk.count; i++) {
+            quads.render_opaque(view, chunk.origin, chunk.pages[i].buf,
+                std::min(PageSlots, chunk.count - i * PageSlots));
+            m_stats.drawn++;
+        }
+    }
+}
+
+void
+RetainedSprites::capture(const QuadRenderer& quads, capture::Frame& frame)
+    const
+{
+    for (const Chunk* chunk : m_drawn) {
+        for (size_t i = 0; i * PageSlots < chunk->count; i++) {
+            quads.capture_opaque(frame, chunk->origin,
+                { chunk->pages[i].instances.data(),
+                    std::min(PageSlots, chunk->count - i * PageSlots) });
+        }
+    }
+}
+
+} // namespace render
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <entt/entity/entity.hpp>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+#include "quad_renderer.hpp"
+
+namespace render {
+
+/// opaque sprites kept in persistent GPU buffers between frames
+///
+/// Each retained sprite entity gets a stable slot in the screen-sized chunk
+/// holding its position, and only the slots of sprites that changed are
+/// rewritten; freed slots are emptied, and reused from the chunk's free
+/// list.  A sprite moving to another chunk moves to a slot there.  Each
+/// chunk's slots are grouped into pages of PageSlots, each in its own GPU
+/// buffer, and only pages with a rewritten slot are uploaded, so the CPU &
+/// upload cost of a frame follows the number of changed sprites rather than
+/// the number of sprites.
+///
+/// Opaque sprites don't need sorting, as they're ordered by the depth test
+/// (see QuadRenderer::draw_opaque_layers()), so slots can be drawn in any
+/// order.  Like the static layer, only the chunks overlapping the camera are
+/// drawn, and their instances are relative to the chunk's corner.
+///
+/// Slots are assigned on the simulation side with update() & remove(), and
+/// handed to the main thread by publish().  The main thread picks them up
+/// with apply(), then draws them with render().  Unlike the snapshot, writes
+/// are never dropped when the main thread falls behind.
+class RetainedSprites {
+public:
+    /// instances in each page; a screen of 16x16 tiles is 220
+    static constexpr size_t PageSlots = 256;
+
+    /// counts from the last calls to apply() & render()
+    struct Stats {
+        size_t slots{ 0 };      // slots in use, including free ones
+        size_t pages{ 0 };
+        size_t chunks{ 0 };
+        size_t writes{ 0 };     // slots rewritten
+        size_t uploaded{ 0 };   // pages uploaded
+        size_t drawn{ 0 };      // pages drawn
+    };
+
+    RetainedSprites() = default;
+    RetainedSprites(const RetainedSprites&) = delete;
+    ~RetainedSprites();
+
+    /// write the quad for an entity's slot, assigning it one in the quad's
+    /// chunk if it has none there
+    void update(entt::entity, const QuadRenderer::LayerQuad&);
+
+    /// free an entity's slot, if it has one
+    void remove(entt::entity);
+
+    /// free every slot
+    void clear();
+
+    /// check if an entity has a slot; simulation side only
+    inline bool contains(entt::entity e) const { return m_slots.contains(e); }
+
+    /// hand the writes since the last publish() to the main thread
+    void publish();
+
+    /// take the published writes, and upload the pages they changed; main
+    /// thread only
+    void apply();
+
+    /// draw the slots of every chunk overlapping the screen at the view's
+    /// camera through QuadRenderer's opaque pass; main thread only
+    void render(QuadRenderer&, const QuadRenderer::View&);
+
+    /// append the slots drawn by the last render() to a capture frame, after
+    /// QuadRenderer::capture(); main thread only
+    void capture(const QuadRenderer&, capture::Frame&) const;
+
+    /// main thread only
+    inline const Stats& stats() const { return m_stats; }
+
+private:
+    struct Slot {
+        uint64_t chunk;     // render::chunk_key()
+        uint32_t index;
+    };
+
+    struct ChunkSlots {
+        std::vector<uint32_t> free{};
+        uint32_t next{ 0 };     // lowest slot never assigned since clear()
+    };
+
+    struct Write {
+        Slot slot;
+        QuadRenderer::LayerQuad quad;   // size 0 for a freed slot
+    };
+
+    struct Page {
+        sg_buffer buf{};
+        std::vector<QuadRenderer::Instance> instances{};
+        bool dirty{ false };
+    };
+
+    struct Chunk {
+        glm::ivec2 origin;      // corner instances are relative to
+        std::vector<Page> pages{};
+        size_t count{ 0 };      // slots drawn; every slot below was written
+        glm::vec2 min;          // bounds of every quad written since clear()
+        glm::vec2 max;
+    };
+
+    // simulation side
+    std::unordered_map<entt::entity, Slot> m_slots{};
+    std::unordered_map<uint64_t, ChunkSlots> m_chunk_slots{};
+    std::vector<Write> m_queued{};
+    bool m_queued_clear{ false };
+
+    // handed from the simulation side to the main thread
+    std::mutex m_mutex;
+    std::vector<Write> m_published{};
+    bool m_published_clear{ false };
+
+    // main thread
+    std::vector<Write> m_applying{};
+    std::unordered_map<uint64_t, Chunk> m_chunks{};
+    std::vector<const Chunk*> m_drawn{};    // by the last render()
+    Stats m_stats{};
+};
+
+} // namespace render
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <sokol_gfx.h>
+
+namespace render {
+
+/// backend to request shader descriptions for from the sokol-shdc headers
+///
+/// Shaders are only generated for glsl330.  The dummy backend used by the
+/// benchmarks never compiles them, so it is handed the GLCORE33 ones.
+inline sg_backend
+shader_backend()
+{
+    sg_backend backend = sg_query_backend();
+    return backend == SG_BACKEND_DUMMY ? SG_BACKEND_GLCORE33 : backend;
+}
+
+} // namespace render
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <chipmunk/chipmunk_types.h>
+#include "../render.hpp"
+
+namespace render {
+
+/// render state captured at the end of a simulation tick
+struct Snapshot {
+    /// sprites to draw, in draw order
+    std::vector<std::pair<Translate, Sprite>> sprites;
+
+    /// opaque sprites to draw with the depth test, in no particular order;
+    /// empty unless the opaque pass was enabled
+    std::vector<std::pair<Translate, Sprite>> opaque;
+
+    /// top-left corner of the camera
+    cpVect camera{ 0, 0 };
+};
+
+/// triple-buffered Snapshot shared between the simulation & the main thread
+///
+/// The simulation fills back() and calls publish(); the main thread calls
+/// acquire() to pick up the newest published snapshot.  Neither side ever
+/// waits on the other, and neither sees a snapshot that is being written.
+class SnapshotBuffer {
+public:
+    /// snapshot to fill in; simulation side only
+    inline Snapshot& back() { return m_buf[m_back]; }
+
+    /// make back() available to the main thread; simulation side only
+    inline void publish() {
+        m_back = m_ready.exchange(m_back | FRESH) & INDEX;
+    }
+
+    /// switch to the newest published snapshot, if any; main thread only
+    inline const Snapshot& acquire() {
+        if (m_ready.load() & FRESH) {
+            m_front = m_ready.exchange(m_front) & INDEX;
+        }
+        return m_buf[m_front];
+    }
+
+    /// snapshot returned by the last acquire(); main thread only
+    inline const Snapshot& current() const { return m_buf[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    std::array<Snapshot, 3> m_buf{};
+    uint8_t m_back{ 0 };
+    uint8_t m_front{ 1 };
+    std::atomic<uint8_t> m_ready{ 2 };
+};
+
+} // namespace render
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include "spatial_grid.hpp"
+
+namespace render {
+
+void
+SpatialGrid::insert_cells(const Entry& entry)
+{
+    for (int y = entry.cell_min.y; y <= entry.cell_max.y; y++) {
+        for (int x = entry.cell_min.x; x <= entry.cell_max.x; x++) {
+            m_cells[key(x, y)].push_back(entry.entity);
+        }
+    }
+}
+
+void
+SpatialGrid::remove_cells(const Entry& entry)
+{
+    for (int y = entry.cell_min.y; y <= entry.cell_max.y; y++) {
+        for (int x = entry.cell_min.x; x <= entry.cell_max.x; x++) {
+            auto& cell = m_cells.find(key(x, y))->second;
+            auto it = std::find(cell.begin(), cell.end(), entry.entity);
+            *it = cell.back();
+            cell.pop_back();
+        }
+    }
+}
+
+void
+SpatialGrid::update(entt::entity e, glm::vec2 min, glm::vec2 max)
+{
+    auto id = entt::to_entity(e);
+    if (id >= m_entries.size()) {
+        m_entries.resize(id + 1);
+    }
+
+    auto& entry = m_entries[id];
+    auto cell_min = cell(min);
+    auto cell_max = cell(max);
+
+    if (entry.entity == e && entry.cell_min == cell_min
+        && entry.cell_max == cell_max) {
+        entry.min = min;
+        entry.max = max;
+        return;
+    }
+
+    if (entry.entity != entt::null) {
+        remove_cells(entry);
+    } else {
+        m_size++;
+    }
+    entry.entity = e;
+    entry.min = min;
+    entry.max = max;
+    entry.cell_min = cell_min;
+    entry.cell_max = cell_max;
+    insert_cells(entry);
+}
+
+void
+SpatialGrid::remove(entt::entity e)
+{
+    auto id = entt::to_entity(e);
+    if (id >= m_entries.size() || m_entries[id].entity != e) {
+        return;
+    }
+
+    auto& entry = m_entries[id];
+    remove_cells(entry);
+    entry = {};
+    m_size--;
+}
+
+void
+SpatialGrid::query(
+    glm::vec2 min, glm::vec2 max, std::vector<entt::entity>& out)
+{
+    // entities spanning multiple cells are only returned once per query
+    m_query++;
+
+    auto cell_min = cell(min);
+    auto cell_max = cell(max);
+    for (int y = cell_min.y; y <= cell_max.y; y++) {
+        for (int x = cell_min.x; x <= cell_max.x; x++) {
+            auto it = m_cells.find(key(x, y));
+            if (it == m_cells.end()) {
+                continue;
+            }
+            for (auto e : it->second) {
+                auto& entry = m_entries[entt::to_entity(e)];
+                if (entry.query == m_query || entry.max.x <= min.x
+                    || entry.min.x >= max.x || entry.max.y <= min.y
+                    || entry.min.y >= max.y) {
+                    continue;
+                }
+                entry.query = m_query;
+                out.push_back(e);
+            }
+        }
+    }
+}
+
+} // namespace render
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <entt/entity/entity.hpp>
+#include <glm/glm.hpp>
+
+namespace render {
+
+/// uniform grid of entity bounds, for finding the entities within a rect
+///
+/// Entities are added to every cell their bounds overlap.  Bounds are only
+/// updated when they change, and moving within the same cells is just a copy
+/// of the new bounds, so the grid is cheap to keep current from the
+/// physics::Moved list.
+class SpatialGrid {
+public:
+    SpatialGrid(float cell_size) : m_cell_size{ cell_size } {};
+
+    /// add an entity, or update its bounds
+    void update(entt::entity, glm::vec2 min, glm::vec2 max);
+
+    /// remove an entity; does nothing if the entity isn't in the grid
+    void remove(entt::entity);
+
+    /// append every entity whose bounds overlap the rect to out
+    void query(glm::vec2 min, glm::vec2 max, std::vector<entt::entity>& out);
+
+    inline size_t size() const { return m_size; }
+
+private:
+    using Key = uint64_t;
+
+    struct Entry {
+        entt::entity entity{ entt::null };
+        glm::vec2 min;
+        glm::vec2 max;
+        glm::ivec2 cell_min;    // range of cells the entity is in
+        glm::ivec2 cell_max;
+        uint32_t query{ 0 };    // last query to return this entity
+    };
+
+    inline glm::ivec2 cell(glm::vec2 pos) const {
+        return glm::ivec2(glm::floor(pos / m_cell_size));
+    }
+    static inline Key key(int x, int y) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32
+            | static_cast<uint32_t>(y);
+    }
+    void insert_cells(const Entry&);
+    void remove_cells(const Entry&);
+
+    float m_cell_size;
+    std::vector<Entry> m_entries{};     // indexed by entity id
+    std::unordered_map<Key, std::vector<entt::entity>> m_cells{};
+    size_t m_size{ 0 };
+    uint32_t m_query{ 0 };
+};
+
+} // namespace render
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sokol_gfx.h>
+
+namespace render {
+
+/// index of a frame in SpriteFrames
+using FrameId = uint32_t;
+
+/// every sprite sheet frame a render::Sprite can draw
+///
+/// Frames are added once while loading, and sprites only hold the FrameId,
+/// so a sprite's texture & UVs are a table lookup rather than a crop matrix
+/// stored in, and applied to, every sprite.
+///
+/// When every frame's texture is also a layer of a texture array, the array
+/// is set with set_layers(), and sprites may be drawn from it with
+/// QuadRenderer::draw_layers() using Frame::layer.  Frames with no
+/// transparent pixels are marked opaque, and drawn with
+/// QuadRenderer::draw_opaque_layers() without being sorted.
+///
+/// The table lives in the registry context.  It is read without locking by
+/// the simulation & render threads, so frames must only be added or cleared
+/// while loading a scene.
+class SpriteFrames {
+public:
+    struct Frame {
+        glm::vec4 uv;   // top-left & size of the crop, normalized
+        sg_image img;
+        uint16_t layer; // layer of img in layers()
+        bool opaque;    // every pixel of the crop is fully opaque
+    };
+
+    /// add a frame, returning its id
+    inline FrameId add(sg_image img, glm::vec4 uv, uint16_t layer = 0,
+        bool opaque = false) {
+        m_frames.push_back({ uv, img, layer, opaque });
+        return m_frames.size() - 1;
+    }
+
+    inline const Frame& operator[](FrameId id) const {
+        assert(id < m_frames.size() && "invalid sprite frame");
+        return m_frames[id];
+    }
+
+    /// texture array holding the texture of every frame, if any
+    inline void set_layers(sg_image array) { m_layers = array; }
+    inline sg_image layers() const { return m_layers; }
+
+    inline size_t size() const { return m_frames.size(); }
+    inline void clear() {
+        m_frames.clear();
+        m_layers = {};
+    }
+
+private:
+    std::vector<Frame> m_frames{};
+    sg_image m_layers{};
+};
+
+} // namespace render
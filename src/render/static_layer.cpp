@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <vector>
+#include <entt/entt.hpp>
+
+#include "../log.hpp"
+#include "../render.hpp"
+#include "static_layer.hpp"
+
+namespace render {
+
+StaticLayer::~StaticLayer()
+{
+    clear();
+}
+
+void
+StaticLayer::clear()
+{
+    for (auto& [key, chunk] : m_chunks) {
+        QuadRenderer::destroy(chunk.mesh);
+    }
+    m_chunks.clear();
+}
+
+void
+StaticLayer::bake(entt::registry& ecs)
+{
+    // chunks are built with the shared QuadRenderer, so this must run before
+    // any sprites are drawn for the frame
+    clear();
+
+    // group the sprites by chunk
+    using Entry = std::pair<Translate, const Sprite*>;
+    std::unordered_map<uint64_t, std::vector<Entry>> sprites;
+    auto view = ecs.view<const Static, const Translate, const Sprite>();
+    const auto& frames = ecs.ctx().get<SpriteFrames>();
+    for (auto&& [e, tsl, sprite] : view.each()) {
+        sprites[chunk_key(tsl.v)].emplace_back(tsl, &sprite);
+    }
+
+    for (auto& [key, entries] : sprites) {
+        // same order as render::publish_snapshot
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const auto& lhs, const auto& rhs) {
+                const auto& l = lhs.first;
+                const auto& r = rhs.first;
+                return l.z == r.z ? l.v.y < r.v.y : l.z < r.z;
+            });
+
+        // vertices are relative to the chunk's corner, which keeps them
+        // within 16 bits wherever the chunk is in the world
+        auto coords = chunk_coords(entries[0].first.v);
+        m_quads.set_origin({ coords.x * static_cast<int>(RESOLUTION.x),
+            coords.y * static_cast<int>(RESOLUTION.y) });
+
+        // draw runs of sprites from the same texture with one draw_rects()
+        std::vector<glm::vec2> pos, size;
+        std::vector<glm::vec4> uv;
+        sg_image texture{};
+        auto flush = [&] {
+            if (!pos.empty()) {
+                m_quads.draw_rects(texture, { pos, size, uv });
+            }
+            pos.clear();
+            size.clear();
+            uv.clear();
+        };
+
+        Chunk chunk{ .min = entries[0].first.v, .max = entries[0].first.v };
+        for (auto& [tsl, sprite] : entries) {
+            auto& frame = frames[sprite->frame];
+            if (frame.img.id != texture.id) {
+                flush();
+                texture = frame.img;
+            }
+            pos.push_back(tsl.v);
+            size.push_back(sprite->res);
+            uv.push_back(frame.uv);
+            chunk.min = glm::min(chunk.min, tsl.v);
+            chunk.max = glm::max(chunk.max, tsl.v + sprite->res);
+        }
+        flush();
+        chunk.mesh = m_quads.bake();
+        m_chunks.emplace(key, chunk);
+    }
+
+    log_debug("baked {} static sprites into {} chunks", view.size_hint(),
+        m_chunks.size());
+}
+
+void
+StaticLayer::render(const QuadRenderer::View& view)
+{
+    glm::vec2 min = view.camera;
+    glm::vec2 max{ min.x + RESOLUTION.x, min.y + RESOLUTION.y };
+
+    for (auto& [key, chunk] : m_chunks) {
+        if (chunk.max.x <= min.x || chunk.min.x >= max.x
+            || chunk.max.y <= min.y || chunk.min.y >= max.y) {
+            continue;
+        }
+        m_quads.render(view, chunk.mesh);
+    }
+}
+
+} // namespace render
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+#include <entt/fwd.hpp>
+#include <glm/glm.hpp>
+#include "quad_renderer.hpp"
+
+namespace render {
+
+/// sprites tagged render::Static, baked into immutable GPU buffers
+///
+/// Static sprites are grouped into screen-sized chunks by position, and each
+/// chunk is expanded into quads & uploaded once by bake().  Drawing is then a
+/// single draw call for each chunk overlapping the camera, with no per-frame
+/// vertex work or upload.
+///
+/// The layer is drawn beneath all other sprites.
+class StaticLayer {
+public:
+    StaticLayer(QuadRenderer& quads) : m_quads{ quads } {};
+    StaticLayer(const StaticLayer&) = delete;
+    ~StaticLayer();
+
+    /// rebuild every chunk from the static sprites in the registry
+    void bake(entt::registry&);
+
+    /// draw the chunks overlapping the screen at the view's camera
+    void render(const QuadRenderer::View&);
+
+    inline size_t chunks() const { return m_chunks.size(); }
+
+private:
+    struct Chunk {
+        QuadRenderer::Mesh mesh{};
+        glm::vec2 min;  // bounds of the sprites in the chunk
+        glm::vec2 max;
+    };
+
+    void clear();
+
+    QuadRenderer& m_quads;
+    std::unordered_map<uint64_t, Chunk> m_chunks{};
+};
+
+} // namespace render
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <sokol_gfx.h>
+#include "../log.hpp"
+#include "buffer.hpp"
+
+namespace render {
+
+/// utilization of a StreamBuffer, in elements
+struct StreamStats {
+    size_t capacity{ 0 };
+    size_t used{ 0 };       // uploaded by the last upload()
+    size_t high_water{ 0 }; // most uploaded by a single upload()
+    size_t grown{ 0 };      // number of times the GPU buffer was grown
+};
+
+/// Buffer that is re-uploaded to the GPU every frame
+///
+/// Data for the frame is collected on the CPU, then uploaded by a single
+/// upload() call before it is drawn.  The GPU buffer uses SG_USAGE_STREAM;
+/// sokol keeps SG_NUM_INFLIGHT_FRAMES copies of it, and rotates to the next
+/// one on the first append of every frame, so we never write to a buffer the
+/// GPU may still be reading from.
+///
+/// When a frame's data doesn't fit, the GPU buffer is recreated at least
+/// twice as large before the upload, so nothing is dropped.
+template <typename T>
+class StreamBuffer : public Buffer<T> {
+public:
+    StreamBuffer(sg_buffer_type type, size_t capacity, const char* label)
+        : m_type{ type }, m_label{ label } {
+        make(capacity);
+    }
+    StreamBuffer(const StreamBuffer&) = delete;
+    ~StreamBuffer() { sg_destroy_buffer(m_buf); }
+
+    inline sg_buffer buffer() const { return m_buf; }
+    inline const StreamStats& stats() const { return m_stats; }
+
+    /// upload the CPU data for this frame, returns the offset of the data
+    /// within buffer()
+    int upload() {
+        size_t count = this->elements();
+        m_stats.used = count;
+        m_stats.high_water = std::max(m_stats.high_water, count);
+        if (count == 0) {
+            return 0;
+        }
+
+        if (count > m_stats.capacity) {
+            size_t capacity = std::max(count, m_stats.capacity * 2);
+            log_debug("grow stream buffer {} from {} to {} elements", m_label,
+                m_stats.capacity, capacity);
+            sg_destroy_buffer(m_buf);
+            make(capacity);
+            m_stats.grown++;
+        }
+        return sg_append_buffer(m_buf, this->sg_range());
+    }
+
+private:
+    void make(size_t capacity) {
+        sg_buffer_desc desc = {
+            .type = m_type,
+            .usage = SG_USAGE_STREAM,
+            .size = capacity * sizeof(T),
+            .label = m_label,
+        };
+        m_buf = sg_make_buffer(&desc);
+        m_stats.capacity = capacity;
+    }
+
+    sg_buffer_type m_type;
+    const char* m_label;
+    sg_buffer m_buf{};
+    StreamStats m_stats{};
+};
+
+} // namespace render
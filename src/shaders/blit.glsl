@@ -0,0 +1,26 @@
+// nearest-neighbour copy of a texture to the viewport; one triangle covers
+// the viewport, and the texture's own filter does the upscaling
+@vs vs
+layout(location=0) in vec2 v_pos;
+
+out vec2 f_uv;
+
+void main() {
+    gl_Position = vec4(v_pos, 0.0, 1.0);
+    f_uv = v_pos * 0.5 + 0.5;
+}
+@end
+
+@fs fs
+uniform sampler2D tex;
+
+in vec2 f_uv;
+
+out vec4 frag_color;
+
+void main() {
+    frag_color = texture(tex, f_uv);
+}
+@end
+
+@program blit vs fs
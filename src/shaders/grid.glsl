@@ -0,0 +1,43 @@
+@header #include <glm/glm.hpp>
+@ctype vec2 glm::vec2
+@ctype vec4 glm::vec4
+
+// fullscreen tile grid; one triangle covers the screen, and the fragment
+// shader finds the grid lines from the world position of each pixel
+@vs vs
+layout(location=0) in vec2 v_pos;
+
+out vec2 f_screen;
+
+void main() {
+    gl_Position = vec4(v_pos, 0.0, 1.0);
+    f_screen = v_pos * 0.5 + 0.5;
+}
+@end
+
+@fs fs
+in vec2 f_screen;
+
+out vec4 frag_color;
+
+uniform fs_params {
+    vec4 u_color;
+    vec2 u_phase;       // camera position relative to a grid line
+    vec2 u_resolution;  // size of the screen in world units
+    vec2 u_tile;        // size of a grid cell
+};
+
+void main() {
+    // screen y increases upwards, world y downwards
+    vec2 pos = u_phase + vec2(f_screen.x, 1.0 - f_screen.y) * u_resolution;
+
+    // distance to the nearest grid line, in world units; a pixel is on the
+    // line when the line passes within half a pixel of its center
+    vec2 dist = abs(fract(pos / u_tile + 0.5) - 0.5) * u_tile;
+    vec2 line = step(dist, fwidth(pos) * 0.5);
+
+    frag_color = u_color * max(line.x, line.y);
+}
+@end
+
+@program grid vs fs
@@ -1,9 +1,11 @@
 @header #include <glm/glm.hpp>
 @ctype mat4 glm::mat4
+@ctype vec2 glm::vec2
 
 @vs vs
 @glsl_options flip_vert_y
-layout(location=0) in vec4 v_pos;
+// position relative to the renderer origin, see QuadRenderer::set_origin()
+layout(location=0) in vec2 v_pos;
 layout(location=1) in float v_texture;
 layout(location=2) in vec2 v_texture_pos;
 layout(location=3) in vec4 v_color;
@@ -12,18 +14,64 @@ out vec4 f_color;
 out flat int f_texture;
 out vec2 f_texture_pos;
 
+// u_mvp is camera-relative; u_origin is the offset of the vertex origin from
+// the camera, so world coordinates never reach the GPU
 uniform vs_params {
     mat4 u_mvp;
+    vec2 u_origin;
 };
 
 void main() {
-    gl_Position = u_mvp * v_pos;
+    gl_Position = u_mvp * vec4(v_pos + u_origin, 0.0, 1.0);
     f_color = v_color;
     f_texture = int(v_texture);
     f_texture_pos = v_texture_pos;
 }
 @end
 
+// one instance per sprite; the unit quad in v_corner is expanded to the
+// sprite's rect & crop
+//
+// i_texture_z is the texture slot or layer, then the sprite's z; z & y give
+// the depth the opaque pass uses in place of sorting, see
+// QuadRenderer::draw_opaque_layers()
+@vs vs_instanced
+@glsl_options flip_vert_y
+layout(location=0) in vec2 v_corner;
+layout(location=1) in vec2 i_pos;
+layout(location=2) in vec2 i_size;
+layout(location=3) in vec4 i_uv;
+layout(location=4) in vec2 i_texture_z;
+layout(location=5) in vec4 i_color;
+
+out vec4 f_color;
+out flat int f_texture;
+out vec2 f_texture_pos;
+
+uniform vs_params {
+    mat4 u_mvp;
+    vec2 u_origin;
+};
+
+void main() {
+    gl_Position =
+        u_mvp * vec4(u_origin + i_pos + v_corner * i_size, 0.0, 1.0);
+
+    // draw order as a depth, nearer for higher z then lower on screen: 8
+    // bits of z, and 14 of camera-relative y in 1/8ths of a pixel, exact in
+    // both a float & a 24-bit depth buffer
+    float y = clamp(floor((u_origin.y + i_pos.y + 1024.0) * 8.0),
+        0.0, 16383.0);
+    float order = (clamp(i_texture_z.y, -128.0, 127.0) + 128.0) * 16384.0
+        + y;
+    gl_Position.z = 1.0 - (order + 1.0) / 2097152.0;
+
+    f_color = i_color;
+    f_texture = int(i_texture_z.x);
+    f_texture_pos = i_uv.xy + v_corner * i_uv.zw;
+}
+@end
+
 @fs fs
 in vec4 f_color;
 in flat int f_texture;
@@ -58,4 +106,22 @@ void main() {
 }
 @end
 
+// sprites from a texture array, where the texture index is the layer; no
+// branching, and as many textures as the array has layers
+@fs fs_array
+in vec4 f_color;
+in flat int f_texture;
+in vec2 f_texture_pos;
+
+out vec4 frag_color;
+
+uniform sampler2DArray u_layers;
+
+void main() {
+    frag_color = texture(u_layers, vec3(f_texture_pos, float(f_texture)));
+}
+@end
+
 @program quad vs fs
+@program quad_instanced vs_instanced fs
+@program quad_array vs_instanced fs_array
@@ -0,0 +1,60 @@
+#include <cassert>
+
+#include "log.hpp"
+#include "sim_thread.hpp"
+
+sim_thread::sim_thread()
+    : m_thread{ &sim_thread::run, this }
+{
+}
+
+sim_thread::~sim_thread()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_quit = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void
+sim_thread::start(std::function<void()> tick)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        assert(!m_busy && "simulation tick already running");
+        m_tick = std::move(tick);
+        m_busy = true;
+    }
+    m_cond.notify_all();
+}
+
+void
+sim_thread::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_cond.wait(lock, [this] { return !m_busy; });
+}
+
+void
+sim_thread::run()
+{
+    log_debug("simulation thread started");
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_cond.wait(lock, [this] { return m_busy || m_quit; });
+        if (m_quit) {
+            break;
+        }
+
+        lock.unlock();
+        m_tick();
+        lock.lock();
+
+        m_tick = nullptr;
+        m_busy = false;
+        m_cond.notify_all();
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// dedicated thread for running the simulation systems of a frame
+///
+/// The main thread hands a single tick to the thread with start(), and must
+/// call wait() before touching the registry again.
+class sim_thread {
+public:
+    sim_thread();
+    sim_thread(const sim_thread&) = delete;
+    ~sim_thread();
+
+    sim_thread& operator=(const sim_thread&) = delete;
+
+    /// run a tick on the simulation thread; the previous tick must be done
+    void start(std::function<void()> tick);
+
+    /// block until the current tick, if any, has completed
+    void wait();
+
+    /// set to true to run simulation systems on this thread
+    bool enabled{ false };
+
+private:
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::function<void()> m_tick{};
+    bool m_busy{ false };
+    bool m_quit{ false };
+    std::thread m_thread;   // last; started once the state above exists
+};
@@ -12,10 +12,25 @@ struct System {
         draw_debug  = 2500,
         render      = 3000,
         imgui_draw  = 4000,
+        imgui_render = 4500,
         flush_frame = 6000,
         cleanup     = 0xffffffff,
     };
 
+    /// thread a system runs on while the simulation thread is enabled; when
+    /// it is disabled, or in step-mode, all systems run in stage order on the
+    /// main thread.
+    enum class Thread : uint8_t {
+        /// on the simulation thread, concurrently with `main_async` systems
+        simulation,
+        /// on the main thread, before the simulation tick is started; has
+        /// exclusive access to the registry
+        main_sync,
+        /// on the main thread, concurrently with the simulation tick; must use
+        /// Config<> and never touch the registry
+        main_async,
+    };
+
     /// helper type so we don't have to type this out everywhere
     template <typename... Args>
     using View = entt::view<entt::get_t<Args...>, entt::exclude_t<>>;
@@ -27,6 +42,7 @@ struct System {
         bool enabled{ true };
         bool always_run{ false };
         unsigned stage;
+        Thread thread{ Thread::simulation };
         std::function<void(entt::registry&, float)> handler;
     };
 
@@ -37,6 +53,7 @@ struct System {
         bool enabled{ true };
         bool always_run{ false };
         unsigned stage;
+        Thread thread{ Thread::simulation };
         std::function<void(entt::registry&, View<T, Args...>&, float)> handler;
     };
 
@@ -49,6 +66,7 @@ struct System {
         , stage{ cfg.stage }
         , enabled{ cfg.enabled }
         , always_run{ cfg.always_run }
+        , thread{ cfg.thread }
     {
         run = [handler = cfg.handler](
                   System& system, entt::registry& reg, float delta) {
@@ -70,6 +88,7 @@ struct System {
         , stage{ cfg.stage }
         , enabled{ cfg.enabled }
         , always_run{ cfg.always_run }
+        , thread{ cfg.thread }
     {
         run = [handler = cfg.handler](
                   System& system, entt::registry& reg, float delta) {
@@ -100,6 +119,9 @@ struct System {
     /// set to true to ensure system runs even during step-mode
     bool always_run{ false };
 
+    /// thread to run the system on when the simulation thread is enabled
+    Thread thread{ Thread::simulation };
+
     /// callback to run the function with the given registry and time delta
     std::function<void(System&, entt::registry&, float)> run;
 
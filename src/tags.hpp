@@ -5,4 +5,7 @@ namespace tags {
 /// add to any entity to have it destroyed at the end of the frame
 struct Destroy {};
 
+/// added to entities in frozen physics rooms; gameplay systems skip these
+struct Dormant {};
+
 } // namespace tags
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cstring>
+#include "texture_array.hpp"
+#include "log.hpp"
+
+TextureArray::~TextureArray()
+{
+    reset();
+}
+
+size_t
+TextureArray::add(const Image& image)
+{
+    assert(image.valid());
+    if (m_layers == 0) {
+        m_width = image.width();
+        m_height = image.height();
+    }
+    assert(image.width() == m_width && image.height() == m_height
+        && "texture array layers must all be the same size");
+
+    // every Image is RGBA, so each layer is exactly image.size() bytes
+    size_t offset = m_pixels.size();
+    m_pixels.resize(offset + image.size());
+    memcpy(&m_pixels[offset], image.data(), image.size());
+
+    log_debug("texture array {}: {} is layer {}", m_label, image.label(),
+        m_layers);
+    return m_layers++;
+}
+
+void
+TextureArray::build()
+{
+    if (m_layers == 0) {
+        return;
+    }
+    int max = sg_query_limits().max_image_array_layers;
+    if (m_layers > static_cast<size_t>(max)) {
+        log_error("texture array {}: {} layers, but at most {} supported",
+            m_label, m_layers, max);
+        return;
+    }
+
+    // all layers are uploaded from a single range
+    sg_image_desc desc = {
+        .type = SG_IMAGETYPE_ARRAY,
+        .width = m_width,
+        .height = m_height,
+        .num_slices = static_cast<int>(m_layers),
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .data.subimage[0][0] = { m_pixels.data(), m_pixels.size() },
+        .label = m_label.c_str(),
+    };
+    m_image = sg_make_image(&desc);
+
+    // the pixels live on the GPU from here on
+    m_pixels = {};
+}
+
+void
+TextureArray::reset()
+{
+    if (m_image.id != SG_INVALID_ID) {
+        log_debug("destroy sg_image {}", m_image.id);
+        sg_destroy_image(m_image);
+        m_image.id = SG_INVALID_ID;
+    }
+    m_pixels.clear();
+    m_layers = 0;
+}
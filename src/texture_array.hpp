@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sokol_gfx.h>
+#include "image.hpp"
+
+/// same-sized images as the layers of a single array texture
+///
+/// Images, such as tilesets or Atlas pages, are copied into the next layer
+/// with add().  Once all layers have been added, build() creates the
+/// SG_IMAGETYPE_ARRAY texture.  QuadRenderer::draw_layers() samples it with
+/// the layer index directly, so every layer shares one texture binding, and
+/// the shader doesn't branch on which texture a sprite uses.
+class TextureArray {
+public:
+    TextureArray(const std::string& label) : m_label{ label } {};
+    TextureArray(const TextureArray&) = delete;
+    ~TextureArray();
+
+    /// copy an image into the next layer, and return the layer; every image
+    /// must be the size of the first
+    size_t add(const Image&);
+
+    /// create the texture from all layers added
+    void build();
+
+    /// free the texture & all layers
+    void reset();
+
+    inline size_t layers() const { return m_layers; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+    inline struct sg_image sg_image() const { return m_image; }
+
+private:
+    std::string m_label;
+    int m_width{ 0 };
+    int m_height{ 0 };
+    size_t m_layers{ 0 };
+    std::vector<uint8_t> m_pixels{};
+    struct sg_image m_image{};
+};
@@ -0,0 +1,90 @@
+#include "log.hpp"
+#include "thread_pool.hpp"
+
+thread_pool::thread_pool(unsigned threads)
+{
+    for (unsigned i = 1; i < threads; i++) {
+        m_workers.emplace_back(&thread_pool::worker, this);
+    }
+    log_debug("started {} worker threads", m_workers.size());
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_workers) {
+        t.join();
+    }
+}
+
+void
+thread_pool::parallel_for(size_t count, const std::function<void(size_t)>& fn)
+{
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || m_workers.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+    job->pending = count;
+    {
+        std::lock_guard lock(m_mutex);
+        m_job = job;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    run(*job);
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [&job] { return job->pending == 0; });
+    m_job.reset();
+}
+
+void
+thread_pool::run(Job& job)
+{
+    // workers waking up late for a finished job never get past this check,
+    // so they never touch `fn` after parallel_for() returned
+    for (size_t i; (i = job.next.fetch_add(1)) < job.count;) {
+        (*job.fn)(i);
+        if (job.pending.fetch_sub(1) == 1) {
+            std::lock_guard lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+void
+thread_pool::worker()
+{
+    uint64_t generation = 0;
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock,
+            [&] { return m_quit || m_generation != generation; });
+        if (m_quit) {
+            break;
+        }
+        generation = m_generation;
+        std::shared_ptr<Job> job = m_job;
+        if (!job) {
+            continue;
+        }
+
+        lock.unlock();
+        run(*job);
+        lock.lock();
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// fixed-size pool of worker threads for data-parallel loops
+class thread_pool {
+public:
+    /// create a pool; the thread calling parallel_for() counts as one of the
+    /// `threads`, so `threads - 1` workers are started
+    thread_pool(unsigned threads = std::thread::hardware_concurrency());
+    thread_pool(const thread_pool&) = delete;
+    ~thread_pool();
+
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// call `fn(i)` for every `i` in `[0, count)` across the pool, and block
+    /// until all calls have returned
+    ///
+    /// Only one thread may call this at a time; code running on different
+    /// threads needs separate pools.
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+    /// number of threads work is spread across, including the caller
+    inline size_t size() const { return m_workers.size() + 1; }
+
+private:
+    struct Job {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> pending{ 0 };
+    };
+
+    void worker();
+    void run(Job&);
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::shared_ptr<Job> m_job{};
+    uint64_t m_generation{ 0 };
+    bool m_quit{ false };
+    std::vector<std::thread> m_workers;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <entt/entt.hpp>
+
+/// storage for components that only live for a single frame
+///
+/// Components like physics::Collision are emplaced during a frame, and are
+/// meaningless by the next one.  Keeping them in regular entt storage means
+/// paying the sparse-set bookkeeping on every add, and then again on every
+/// remove in a sweep system.
+///
+/// Transient<T> stamps each entry with the epoch it was added in.  Bumping
+/// the epoch with clear() makes every entry invisible at once, without
+/// touching them.  Entries are kept densely packed, so iteration only ever
+/// visits the components added during the current epoch.
+///
+/// A component is declared transient by emplacing its storage in the registry
+/// context; after that it must only be accessed through transient<T>().
+template <typename T>
+class Transient {
+public:
+    using value_type = std::pair<entt::entity, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+
+    /// add or replace the component for an entity in the current epoch
+    template <typename... Args>
+    T& emplace_or_replace(entt::entity e, Args&&... args) {
+        auto id = entt::to_entity(e);
+        if (id >= m_sparse.size()) {
+            m_sparse.resize(id + 1);
+        }
+
+        auto& slot = m_sparse[id];
+        if (slot.epoch == m_epoch && m_dense[slot.index].first == e) {
+            auto& v = m_dense[slot.index].second;
+            v = T{ std::forward<Args>(args)... };
+            return v;
+        }
+
+        slot = { m_epoch, static_cast<uint32_t>(m_dense.size()) };
+        return m_dense.emplace_back(e, T{ std::forward<Args>(args)... })
+            .second;
+    }
+
+    /// check if the entity has the component in the current epoch
+    inline bool contains(entt::entity e) const { return find(e) != nullptr; }
+
+    /// get the component for an entity, nullptr if not present
+    inline T* find(entt::entity e) {
+        return const_cast<T*>(std::as_const(*this).find(e));
+    }
+    inline const T* find(entt::entity e) const {
+        auto id = entt::to_entity(e);
+        if (id >= m_sparse.size() || m_sparse[id].epoch != m_epoch) {
+            return nullptr;
+        }
+        auto& p = m_dense[m_sparse[id].index];
+        return p.first == e ? &p.second : nullptr;
+    }
+
+    /// get the component for an entity; entity must have the component
+    inline T& get(entt::entity e) {
+        T* v = find(e);
+        assert(v != nullptr && "entity does not have transient component");
+        return *v;
+    }
+
+    /// drop all components by starting a new epoch
+    ///
+    /// O(1) for trivially destructible components; stale sparse entries are
+    /// never reset, they just stop matching the epoch.
+    inline void clear() {
+        ++m_epoch;
+        m_dense.clear();
+    }
+
+    inline size_t size() const { return m_dense.size(); }
+    inline bool empty() const { return m_dense.empty(); }
+    inline iterator begin() { return m_dense.begin(); }
+    inline iterator end() { return m_dense.end(); }
+
+private:
+    struct Slot {
+        uint32_t epoch{ 0 };
+        uint32_t index{ 0 };
+    };
+
+    uint32_t m_epoch{ 1 };  // start at 1 so default slots never match
+    std::vector<Slot> m_sparse{};
+    std::vector<value_type> m_dense{};
+};
+
+/// get the transient storage for a component from the registry context
+template <typename T>
+inline Transient<T>&
+transient(entt::registry& ecs)
+{
+    return ecs.ctx().get<Transient<T>>();
+}